@@ -0,0 +1,91 @@
+#!/bin/sh
+# Times every analyser and every template set on synthetic and real grammars.
+#
+#   bench/generator.sh [results.jsonl]
+#
+# Environment:
+#   ANALYSERS  analysers to run               (LR0 SLR1 LALR1 CLR1)
+#   SIZES      synthetic grammar rule counts  (100 1000 5000)
+#   PATTERNS   synthetic grammar patterns     (plain left right optional prefix expr mixed
+#                                              operator dangling)
+#   TERMINALS  synthetic terminal count       (64)
+#   DEPTH      synthetic nesting depth        (8)
+#   TIMEOUT    seconds per run                (120)
+#
+# Every run appends one JSON object to the results file with the grammar,
+# analyser and template set next to the output of parcelr --stats=json.
+# The operator pattern resolves its conflicts with %left, the dangling one
+# keeps them and is generated with --glr.
+
+set -e
+cd "$(dirname "$0")/.."
+
+ANALYSERS=${ANALYSERS:-"LR0 SLR1 LALR1 CLR1"}
+SIZES=${SIZES:-"100 1000 5000"}
+PATTERNS=${PATTERNS:-"plain left right optional prefix expr mixed operator dangling"}
+TERMINALS=${TERMINALS:-64}
+DEPTH=${DEPTH:-8}
+TIMEOUT=${TIMEOUT:-120}
+
+BUILD=bench/build
+RESULTS=${1:-$BUILD/generator.jsonl}
+
+mkdir -p $BUILD/grammars $BUILD/c $BUILD/odin
+odin build . -o:speed -out:$BUILD/parcelr
+odin build bench/synth -o:speed -out:$BUILD/synth
+: > "$RESULTS"
+
+for size in $SIZES; do
+	for pattern in $PATTERNS; do
+		$BUILD/synth --rules=$size --terminals=$TERMINALS --depth=$DEPTH --pattern=$pattern \
+			> $BUILD/grammars/synth_${pattern}_$size.txt
+	done
+done
+
+# first integer following the given key
+json_int() {
+	printf '%s\n' "$2" | awk -v k="$1" '{ i = index($0, k); s = substr($0, i + length(k)); sub(/[^0-9].*/, "", s); print s }'
+}
+
+ms() {
+	awk -v ns="$1" 'BEGIN { printf "%.2f", ns / 1000000 }'
+}
+
+printf '%-28s %-6s %-5s %8s %10s %10s %10s %10s %10s\n' \
+	grammar type tmpl states entries table_ms eval_ms total_ms out_bytes
+
+for grammar in bench/grammars/*.txt examples/json_c.txt $BUILD/grammars/*.txt; do
+	name=$(basename "$grammar" .txt)
+	case $name in
+	synth_dangling_*) glr=--glr ;;
+	*) glr= ;;
+	esac
+	for analyser in $ANALYSERS; do
+		for set in c odin; do
+			case $set in
+			c) templates="templates/c/parser.h templates/c/parser.c templates/c/stack.h" ;;
+			odin) templates="templates/odin/parser.odin" ;;
+			esac
+
+			stats=$(timeout $TIMEOUT $BUILD/parcelr --quiet --stats=json $glr $analyser "$grammar" $BUILD/$set $templates || true)
+			case $stats in
+			"{"*) ;;
+			*)
+				printf '%-28s %-6s %-5s %s\n' "$name" $analyser $set "${stats:-timeout}"
+				continue
+				;;
+			esac
+
+			printf '{"grammar":"%s","analyser":"%s","templates":"%s","stats":%s}\n' \
+				"$name" $analyser $set "$stats" >> "$RESULTS"
+
+			printf '%-28s %-6s %-5s %8s %10s %10s %10s %10s %10s\n' "$name" $analyser $set \
+				$(json_int '"states":' "$stats") \
+				$(json_int '"table_entries":' "$stats") \
+				$(ms $(json_int '"calc_table":{"time_ns":' "$stats")) \
+				$(ms $(json_int '"eval":{"time_ns":' "$stats")) \
+				$(ms $(json_int '"total_ns":' "$stats")) \
+				$(json_int '"output_bytes":' "$stats")
+		done
+	done
+done
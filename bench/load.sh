@@ -0,0 +1,40 @@
+#!/bin/sh
+# Times parse_grammar on large synthetic grammars and the real ones.
+#
+#   bench/load.sh
+#
+# Environment:
+#   SIZES      synthetic grammar rule counts  (5000 50000)
+#   PATTERNS   synthetic grammar patterns     (plain prefix expr mixed)
+#   TERMINALS  synthetic terminal count       (64)
+#   RUNS       parses per grammar             (10)
+
+set -e
+cd "$(dirname "$0")/.."
+
+SIZES=${SIZES:-"5000 50000"}
+PATTERNS=${PATTERNS:-"plain prefix expr mixed"}
+TERMINALS=${TERMINALS:-64}
+RUNS=${RUNS:-10}
+
+BUILD=bench/build
+
+mkdir -p $BUILD/grammars
+odin build bench/synth -o:speed -out:$BUILD/synth
+odin build bench/load -o:speed -out:$BUILD/load
+
+for size in $SIZES; do
+	for pattern in $PATTERNS; do
+		$BUILD/synth --rules=$size --terminals=$TERMINALS --pattern=$pattern \
+			> $BUILD/grammars/synth_${pattern}_$size.txt
+	done
+done
+
+grammars=""
+for size in $SIZES; do
+	for pattern in $PATTERNS; do
+		grammars="$grammars $BUILD/grammars/synth_${pattern}_$size.txt"
+	done
+done
+
+$BUILD/load --runs=$RUNS bench/grammars/*.txt examples/json_c.txt $grammars
@@ -0,0 +1,72 @@
+package load
+
+// Times parse_grammar on its own: every file is read once and parsed the
+// given number of times, the fastest run is reported.
+
+import "core:fmt"
+import "core:os"
+import "core:strconv"
+import "core:strings"
+import "core:time"
+
+import "../../grammar"
+
+USAGE :: `load [--runs=N] GRAMMAR...`
+
+main :: proc() {
+	runs := 10
+	files := make([dynamic]string)
+	defer delete(files)
+
+	for arg in os.args[1:] {
+		if strings.has_prefix(arg, "--runs=") {
+			n, ok := strconv.parse_int(arg[len("--runs="):])
+			if !ok || n < 1 {
+				fmt.eprintln(USAGE)
+				os.exit(1)
+			}
+			runs = n
+		} else {
+			append(&files, arg)
+		}
+	}
+	if len(files) == 0 {
+		fmt.eprintln(USAGE)
+		os.exit(1)
+	}
+
+	fmt.printf("%-28s %10s %8s %8s %10s\n", "grammar", "bytes", "rules", "symbols", "parse_ms")
+	for path in files {
+		data, ok := os.read_entire_file(path)
+		if !ok {
+			fmt.eprintf("could not read %s\n", path)
+			os.exit(1)
+		}
+		defer delete(data)
+
+		best := time.Duration(max(i64))
+		rules, symbols: int
+		for _ in 0 ..< runs {
+			start := time.tick_now()
+			g, err := grammar.parse_grammar(data)
+			elapsed := time.tick_since(start)
+			if err != {} {
+				fmt.eprintf("could not parse %s: %s\n", path, err)
+				os.exit(1)
+			}
+			rules, symbols = len(g.rules), len(g.symbols)
+			grammar.delete_grammar(g)
+			best = min(best, elapsed)
+		}
+
+		name := strings.trim_suffix(path[strings.last_index_byte(path, '/') + 1:], ".txt")
+		fmt.printf(
+			"%-28s %10d %8d %8d %10.2f\n",
+			name,
+			len(data),
+			rules,
+			symbols,
+			time.duration_milliseconds(best),
+		)
+	}
+}
@@ -0,0 +1,125 @@
+#!/bin/sh
+# Times the generated C and Odin JSON parsers on a large document.
+#
+#   bench/runtime.sh [results.jsonl]
+#
+# Environment:
+#   TEMPLATES   directory holding the c/ and odin/ template sets  (templates)
+#   LABEL       name recorded next to the results                 (basename of TEMPLATES)
+#   ANALYSER    analyser used to generate the parsers             (LALR1)
+#   BACKENDS    backends to run, glr is the C GLR parser and tape (c odin)
+#               the C parser writing a tape of examples/json_tape_c.txt
+#   MEGABYTES   size of the generated document                    (16)
+#   ITERATIONS  runs per backend, the fastest one is reported     (5)
+#   CC, CFLAGS  C compiler and flags                              (cc, -O2)
+#   ODINFLAGS   extra flags for the Odin parser, e.g.
+#               -define:PARCELR_TYPED_STACKS=true
+#   PROFILE     set to 1 to build the parsers with profiling, which also
+#               reports the stack depth and writes the state and rule
+#               counters to bench/build/runtime/LABEL/BACKEND.profile
+#
+# To compare the two stack layouts of the generated parsers:
+#
+#   LABEL=typed CFLAGS="-O2 -DPARCELR_TYPED_STACKS" \
+#     ODINFLAGS=-define:PARCELR_TYPED_STACKS=true bench/runtime.sh results.jsonl
+#
+# To compare the Swiss tables of the JSON objects with the previous hashmap:
+#
+#   LABEL=hashmap CFLAGS="-O2 -DJSON_HASHMAP" bench/runtime.sh results.jsonl
+#   LABEL=swiss bench/runtime.sh results.jsonl
+#
+# To compare arrays allocated one by one with arrays pushed into an arena
+# per parse (not used by the tape):
+#
+#   LABEL=arena CFLAGS="-O2 -DJSON_ARENA" BACKENDS="c glr" bench/runtime.sh results.jsonl
+#   LABEL=malloc BACKENDS="c glr" bench/runtime.sh results.jsonl
+#
+# To compare template variants, run it once per variant with a different
+# TEMPLATES and LABEL and the same results file, e.g. on a checkout of the
+# previous templates:
+#
+#   TEMPLATES=/tmp/old/templates LABEL=old bench/runtime.sh results.jsonl
+#   LABEL=new bench/runtime.sh results.jsonl
+
+set -e
+cd "$(dirname "$0")/.."
+
+TEMPLATES=${TEMPLATES:-templates}
+LABEL=${LABEL:-$(basename "$TEMPLATES")}
+ANALYSER=${ANALYSER:-LALR1}
+BACKENDS=${BACKENDS:-"c odin"}
+MEGABYTES=${MEGABYTES:-16}
+ITERATIONS=${ITERATIONS:-5}
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:-"-O2"}
+PROFILE=${PROFILE:-0}
+
+BUILD=bench/build/runtime/$LABEL
+RESULTS=${1:-bench/build/runtime.jsonl}
+
+mkdir -p $BUILD/c $BUILD/parser
+odin build . -o:speed -out:bench/build/parcelr
+
+ODINFLAGS=${ODINFLAGS:-}
+if [ "$PROFILE" = 1 ]; then
+	CFLAGS="$CFLAGS -DPARCELR_PROFILE"
+	ODINFLAGS="$ODINFLAGS -define:PARCELR_PROFILE=true"
+fi
+
+# first number following the given key
+json_num() {
+	printf '%s\n' "$2" | awk -v k="$1" '{ i = index($0, k); if (i == 0) next; s = substr($0, i + length(k)); sub(/[^0-9.].*/, "", s); print s }'
+}
+
+printf '%-12s %-5s %10s %10s %12s %10s %12s %10s %12s %8s %6s\n' \
+	label back tokens lex_ms lex_MB/s parse_ms parse_tok/s parse_MB/s allocs walk_ms depth
+
+for backend in $BACKENDS; do
+	case $backend in
+	c)
+		bench/build/parcelr --quiet $ANALYSER examples/json_c.txt $BUILD/c \
+			$TEMPLATES/c/parser.h $TEMPLATES/c/parser.c $TEMPLATES/c/stack.h
+		cp examples/c/array.h examples/c/hashmap.h examples/c/swisstable.h examples/c/json_value.h $BUILD/c
+		$CC $CFLAGS -I$BUILD/c bench/runtime/c/bench.c -o $BUILD/bench_c
+		;;
+	glr)
+		mkdir -p $BUILD/glr
+		bench/build/parcelr --quiet --glr $ANALYSER examples/json_c.txt $BUILD/glr \
+			$TEMPLATES/c/parser.h $TEMPLATES/c/glr.h $TEMPLATES/c/glr.c $TEMPLATES/c/stack.h
+		cp examples/c/array.h examples/c/hashmap.h examples/c/swisstable.h examples/c/json_value.h $BUILD/glr
+		$CC $CFLAGS -DPARCELR_GLR -I$BUILD/glr bench/runtime/c/bench.c -o $BUILD/bench_glr
+		;;
+	tape)
+		mkdir -p $BUILD/tape
+		bench/build/parcelr --quiet $ANALYSER examples/json_tape_c.txt $BUILD/tape \
+			$TEMPLATES/c/parser.h $TEMPLATES/c/parser.c $TEMPLATES/c/stack.h
+		$CC $CFLAGS -DPARCELR_TAPE -I$BUILD/tape bench/runtime/c/bench.c -o $BUILD/bench_tape
+		;;
+	odin)
+		bench/build/parcelr --quiet $ANALYSER examples/json.txt $BUILD/parser \
+			$TEMPLATES/odin/parser.odin
+		odin build bench/runtime/odin -o:speed -collection:generated=$BUILD \
+			-define:PARCELR_DEBUG=false $ODINFLAGS -out:$BUILD/bench_odin
+		;;
+	*)
+		echo "unknown backend: $backend" >&2
+		exit 1
+		;;
+	esac
+
+	result=$($BUILD/bench_$backend $MEGABYTES $ITERATIONS $BUILD/$backend.profile)
+	depth=$(json_num '"max_depth":' "$result")
+	walk=$(json_num '"walk_ns":' "$result")
+	printf '{"label":"%s","analyser":"%s","result":%s}\n' "$LABEL" $ANALYSER "$result" >> "$RESULTS"
+
+	printf '%-12s %-5s %10s %10s %12s %10s %12s %10s %12s %8s %6s\n' "$LABEL" $backend \
+		$(json_num '"tokens":' "$result") \
+		$(awk -v ns=$(json_num '"lex_ns":' "$result") 'BEGIN { printf "%.2f", ns / 1000000 }') \
+		$(json_num '"lex_mb_per_s":' "$result") \
+		$(awk -v ns=$(json_num '"parse_ns":' "$result") 'BEGIN { printf "%.2f", ns / 1000000 }') \
+		$(json_num '"parse_tokens_per_s":' "$result") \
+		$(json_num '"parse_mb_per_s":' "$result") \
+		$(json_num '"allocations":' "$result") \
+		$(if [ -n "$walk" ]; then awk -v ns=$walk 'BEGIN { printf "%.2f", ns / 1000000 }'; else echo -; fi) \
+		${depth:--}
+done
@@ -0,0 +1,190 @@
+// Times the generated C JSON parser (examples/json_c.txt) on a large document.
+//
+//   bench [megabytes] [iterations] [profile]
+//
+// Built as a single translation unit together with the generated parser.c,
+// so every allocation made by the parser and its semantic actions goes
+// through the counting allocator below. Prints one JSON object. Built with
+// -DPARCELR_PROFILE it also reports the stack depth and writes the parser
+// profile to the given file. Built with -DPARCELR_GLR it times the GLR
+// parser generated from glr.c instead, and with -DPARCELR_TAPE the parser
+// generated from examples/json_tape_c.txt writing a tape. Walking the
+// result once, counting its values and adding up its numbers, is timed as
+// well. Built with -DJSON_ARENA the arrays of every parse are pushed into
+// an arena handed to it as the context, except for the tape.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static size_t allocations, live, peak;
+
+// every block carries its size in front, aligned for any type
+typedef union {
+  size_t size;
+  max_align_t _align;
+} header;
+
+static void *counting_malloc(size_t size) {
+  header *h = (header*)malloc(sizeof(header) + size);
+  if (h == NULL) return NULL;
+  h->size = size;
+  allocations++;
+  live += size;
+  if (live > peak) peak = live;
+  return h + 1;
+}
+
+static void counting_free(void *ptr) {
+  if (ptr == NULL) return;
+  header *h = (header*)ptr - 1;
+  live -= h->size;
+  free(h);
+}
+
+static void *counting_calloc(size_t count, size_t size) {
+  void *ptr = counting_malloc(count * size);
+  if (ptr != NULL) memset(ptr, 0, count * size);
+  return ptr;
+}
+
+static void *counting_realloc(void *ptr, size_t size) {
+  void *newptr = counting_malloc(size);
+  if (ptr != NULL && newptr != NULL) {
+    size_t old = ((header*)ptr - 1)->size;
+    memcpy(newptr, ptr, old < size ? old : size);
+    counting_free(ptr);
+  }
+  return newptr;
+}
+
+#define malloc  counting_malloc
+#define free    counting_free
+#define calloc  counting_calloc
+#define realloc counting_realloc
+
+#if defined(JSON_ARENA) && !defined(PARCELR_TAPE)
+struct array_arena_s;
+#define PARCELR_CONTEXT struct array_arena_s
+#define ARENA , &arena
+#else
+#define ARENA
+#endif
+
+#ifdef PARCELR_GLR
+#include "glr.c"
+#define BACKEND "glr"
+#elif defined(PARCELR_TAPE)
+#include "parser.c"
+#define BACKEND "tape"
+#else
+#include "parser.c"
+#define BACKEND "c"
+#endif
+
+#include "json.h"
+
+int main(int argc, char **argv) {
+  size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 16;
+  unsigned iterations = argc > 2 ? strtoul(argv[2], NULL, 10) : 5;
+  if (iterations == 0) iterations = 1;
+
+  size_t length;
+  char *text = make_document(megabytes << 20, &length);
+
+  double lex_best = 1e9, parse_best = 1e9, walk_best = 1e9;
+  size_t parse_allocations = 0, parse_peak = 0;
+  unsigned count = 0;
+  walk w = {0};
+
+  for (unsigned it = 0; it < iterations; it++) {
+    tokens t = { (token*)malloc(sizeof(token) * 1024), 0, 1024 };
+
+    double start = now();
+    if (!lex(text, length, &t)) {
+      fprintf(stderr, "could not lex document\n");
+      return 1;
+    }
+    double lexed = now();
+    if (lexed - start < lex_best) lex_best = lexed - start;
+    count = t.length;
+
+    // copied outside the timed region, a parse overwrites its input
+    struct stack_s input = input_stack(t);
+    free(t.data);
+
+    size_t before = allocations;
+    size_t base = live;
+    peak = live;
+
+    start = now();
+#if defined(PARCELR_TAPE)
+    struct parser_tape value = {0};
+    bool ok = parser_parse(input, &value);
+#elif defined(PARCELR_GLR)
+    struct array_arena_s arena = {0};
+    json_value value = {0};
+    struct glr_forest forest;
+    bool ok = glr_parse(input, &forest ARENA);
+    if (ok) glr_eval(&forest, &value ARENA);
+#else
+    struct array_arena_s arena = {0};
+    json_value value = {0};
+    bool ok = parser_parse(input, &value ARENA);
+#endif
+    double parsed = now();
+
+    if (!ok) {
+      fprintf(stderr, "could not parse document\n");
+      return 1;
+    }
+    if (parsed - start < parse_best) parse_best = parsed - start;
+    parse_allocations = allocations - before;
+    parse_peak = peak - base;
+
+    w = (walk){0};
+    start = now();
+    json_walk(value, &w);
+    double walked = now();
+    if (walked - start < walk_best) walk_best = walked - start;
+
+#ifdef PARCELR_TAPE
+    parser_tape_destroy(&value);
+#else
+    json_free(value);
+    array_arena_destroy(&arena);
+#endif
+#ifdef PARCELR_GLR
+    glr_forest_destroy(&forest);
+#endif
+    stack_destroy(input);
+  }
+
+  double mb = length / (double)(1 << 20);
+  printf("{\"backend\":\"" BACKEND "\",\"bytes\":%zu,\"tokens\":%u,\"iterations\":%u,", length, count, iterations);
+  printf("\"lex_ns\":%.0f,\"lex_tokens_per_s\":%.0f,\"lex_mb_per_s\":%.1f,",
+    lex_best * 1e9, count / lex_best, mb / lex_best);
+  printf("\"parse_ns\":%.0f,\"parse_tokens_per_s\":%.0f,\"parse_mb_per_s\":%.1f,",
+    parse_best * 1e9, count / parse_best, mb / parse_best);
+  printf("\"allocations\":%zu,\"peak_bytes\":%zu,", parse_allocations, parse_peak);
+  printf("\"walk_ns\":%.0f,\"values\":%u,\"sum\":%.1f", walk_best * 1e9, w.count, w.sum);
+#if defined(PARCELR_PROFILE) && !defined(PARCELR_GLR)
+  printf(",\"max_depth\":%u", parser_profile_data.max_depth);
+  if (argc > 3) {
+    FILE *file = fopen(argv[3], "w");
+    if (file == NULL) {
+      fprintf(stderr, "could not write profile\n");
+      return 1;
+    }
+    parser_profile_write(file, &parser_profile_data);
+    fclose(file);
+  }
+#endif
+  printf("}\n");
+
+  free(text);
+  return 0;
+}
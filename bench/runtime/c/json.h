@@ -0,0 +1,207 @@
+// The document, its lexer and the walk over its parse shared by bench.c,
+// threads.c and lines.c, included after the generated parser. With
+// JSON_LINES the records are on lines of their own, for json_lines_c.txt.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// the same document as bench/runtime/odin, a list of nested records
+static char *make_document(size_t target, size_t *length) {
+  size_t capacity = target + 4096;
+  char *text = (char*)malloc(capacity);
+  size_t len = 0;
+
+#ifndef JSON_LINES
+  text[len++] = '[';
+#endif
+  for (unsigned i = 0; len < target; i++) {
+#ifdef JSON_LINES
+    if (i > 0) text[len++] = '\n';
+#else
+    if (i > 0) text[len++] = ',';
+    text[len++] = '\n';
+#endif
+    len += snprintf(text + len, capacity - len,
+      "  {\"id\": %u, \"name\": \"item %u\", \"tags\": [\"t%u\", \"t%u\"], \"active\": %s, "
+      "\"score\": %u.5e-1, \"parent\": null, \"nested\": {\"depth\": %u, \"values\": [%u, %u, -%u], \"empty\": {}}}",
+      i, i, i % 7, i % 11, i % 2 ? "true" : "false", i, i % 5, i, i + 1, i + 2);
+  }
+#ifndef JSON_LINES
+  text[len++] = '\n';
+  text[len++] = ']';
+#endif
+  text[len] = '\0';
+
+  *length = len;
+  return text;
+}
+
+typedef struct {
+  parser_symbol symbol;
+  union {
+    json_string string;
+    double number;
+  } value;
+} token;
+
+typedef struct {
+  token   *data;
+  unsigned length;
+  unsigned capacity;
+} tokens;
+
+static void emit(tokens *t, token tok) {
+  if (t->length == t->capacity) {
+    t->capacity *= 2;
+    t->data = (token*)realloc(t->data, sizeof(token) * t->capacity);
+  }
+  t->data[t->length++] = tok;
+}
+
+static bool lex(const char *text, size_t length, tokens *out) {
+  size_t i = 0;
+  while (i < length) {
+    char c = text[i];
+    token tok = {0};
+
+    switch (c) {
+#ifdef JSON_LINES
+      case '\n': tok.symbol = SYMBOL_NEWLINE;       i++; break;
+      case ' ': case '\t': case '\r':
+#else
+      case ' ': case '\t': case '\n': case '\r':
+#endif
+        i++;
+        continue;
+      case '{': tok.symbol = SYMBOL_OPEN_BRACE;    i++; break;
+      case '}': tok.symbol = SYMBOL_CLOSE_BRACE;   i++; break;
+      case '[': tok.symbol = SYMBOL_OPEN_BRACKET;  i++; break;
+      case ']': tok.symbol = SYMBOL_CLOSE_BRACKET; i++; break;
+      case ',': tok.symbol = SYMBOL_COMMA;         i++; break;
+      case ':': tok.symbol = SYMBOL_COLON;         i++; break;
+      case '"':
+      {
+        size_t start = ++i;
+        while (i < length && text[i] != '"') i++;
+        if (i == length) return false;
+        tok.symbol = SYMBOL_string;
+        tok.value.string = (json_string){ &text[start], (unsigned)(i - start) };
+        i++;
+        break;
+      }
+      default:
+      {
+        if (strncmp(&text[i], "true", 4) == 0)  { tok.symbol = SYMBOL_TRUE;  i += 4; break; }
+        if (strncmp(&text[i], "false", 5) == 0) { tok.symbol = SYMBOL_FALSE; i += 5; break; }
+        if (strncmp(&text[i], "null", 4) == 0)  { tok.symbol = SYMBOL_NULL;  i += 4; break; }
+
+        char *end;
+        tok.symbol = SYMBOL_number;
+        tok.value.number = strtod(&text[i], &end);
+        if (end == &text[i]) return false;
+        i = end - text;
+        break;
+      }
+    }
+
+    emit(out, tok);
+  }
+  return true;
+}
+
+// the parser pops its input, so the first token goes on top
+static struct stack_s input_stack(tokens t) {
+  // a symbol and at most one value per token, the parser never pushes
+  // onto its input
+  struct stack_s input = stack_make(t.length * 2 + 1);
+
+  parser_symbol eof = SYMBOL_EOF;
+  stack_push(input, eof);
+
+  for (unsigned i = t.length; i-- > 0;) {
+    token tok = t.data[i];
+    if (tok.symbol == SYMBOL_string) stack_push(input, tok.value.string);
+    if (tok.symbol == SYMBOL_number) stack_push(input, tok.value.number);
+    stack_push(input, tok.symbol);
+  }
+  return input;
+}
+
+// values counted and numbers added up by a walk
+typedef struct {
+  unsigned count;
+  double   sum;
+} walk;
+
+#ifdef PARCELR_TAPE
+// the nodes are in postorder, so one pass visits every value
+static void json_walk(struct parser_tape tape, walk *w) {
+  for (unsigned i = 0; i < tape.length; i++) {
+    const struct parser_node *node = &tape.data[i];
+    if (node->symbol == SYMBOL_value) w->count++;
+    if (node->symbol == SYMBOL_number) w->sum += node->value._0;
+  }
+}
+#else
+static void json_walk(json_value value, walk *w);
+
+static int walk_member(void *const context, void *const data) {
+  json_walk(*(json_value*)data, (walk*)context);
+  return 1;
+}
+
+static void json_walk(json_value value, walk *w) {
+  w->count++;
+  switch (value.type) {
+    case JSON_OBJECT:
+      json_object_iterate(&value.data.object, walk_member, w);
+      break;
+    case JSON_ARRAY:
+      for (unsigned i = 0; i < value.data.array.length; i++) {
+        json_walk(array_elem(value.data.array, json_value, i), w);
+      }
+      break;
+    case JSON_NUMBER:
+      w->sum += value.data.number;
+      break;
+    default:
+      break;
+  }
+}
+
+static void json_free(json_value value);
+
+static int free_member(void *const context, void *const data) {
+  json_free(*(json_value*)data);
+  free(data);
+  return 1;
+}
+
+static void json_free(json_value value) {
+  switch (value.type) {
+    case JSON_OBJECT:
+      json_object_iterate(&value.data.object, free_member, NULL);
+      json_object_destroy(&value.data.object);
+      break;
+    case JSON_ARRAY:
+      for (unsigned i = 0; i < value.data.array.length; i++) {
+        json_free(array_elem(value.data.array, json_value, i));
+      }
+      json_array_destroy(value.data.array);
+      break;
+    default:
+      break;
+  }
+}
+#endif
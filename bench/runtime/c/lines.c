@@ -0,0 +1,91 @@
+// Times one newline delimited JSON document parsed by parser_parse_split
+// on 1, 2, 4 ... threads, to see how far splitting a single input at its
+// lines speeds up parsing it.
+//
+//   lines [megabytes] [threads] [iterations]
+//
+// Built against json_lines_c.txt with split.c. Threads default to, or with
+// 0 are, the number of cores. Every parse is checked against the one of a
+// single thread by walking its result, which is timed along with the parse
+// and freeing it. Prints one JSON object per thread count like threads.c,
+// throughput counts the bytes of the document once per parse.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define JSON_LINES
+
+#include "parser.c"
+#include "split.c"
+
+#include "json.h"
+
+// the wall time of every iteration on the given threads, -1 when a parse
+// failed or its result differs from expected
+static double run(const struct stack_s *lexemes, unsigned threads, unsigned iterations,
+                  walk *w, const walk *expected) {
+  double start = now();
+  for (unsigned it = 0; it < iterations; it++) {
+    json_value value = { JSON_ARRAY };
+    if (!parser_parse_split(*lexemes, threads, &value.data.array)) return -1;
+
+    *w = (walk){0};
+    json_walk(value, w);
+    json_free(value);
+  }
+  double elapsed = now() - start;
+
+  if (expected && (w->count != expected->count || w->sum != expected->sum)) return -1;
+  return elapsed;
+}
+
+int main(int argc, char **argv) {
+  size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 4;
+  unsigned most = argc > 2 ? strtoul(argv[2], NULL, 10) : 0;
+  unsigned iterations = argc > 3 ? strtoul(argv[3], NULL, 10) : 3;
+  if (most == 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    most = cores > 0 ? (unsigned)cores : 1;
+  }
+  if (iterations == 0) iterations = 1;
+
+  size_t length;
+  char *text = make_document(megabytes << 20, &length);
+
+  tokens t = { (token*)malloc(sizeof(token) * 1024), 0, 1024 };
+  if (!lex(text, length, &t)) {
+    fprintf(stderr, "could not lex document\n");
+    return 1;
+  }
+  struct stack_s lexemes = input_stack(t);
+  free(t.data);
+
+  double single = 0;
+  walk expected = {0};
+  for (unsigned count = 1;; count = count * 2 < most ? count * 2 : most) {
+    walk w;
+    double elapsed = run(&lexemes, count, iterations, &w, count == 1 ? NULL : &expected);
+    if (elapsed < 0) {
+      fprintf(stderr, "could not parse document on %u threads\n", count);
+      return 1;
+    }
+    if (count == 1) {
+      single = elapsed;
+      expected = w;
+    }
+
+    double mb = (double)length * iterations / (1 << 20);
+    printf("{\"backend\":\"split\",\"bytes\":%zu,\"threads\":%u,\"iterations\":%u,", length, count, iterations);
+    printf("\"ns\":%.0f,\"mb_per_s\":%.1f,\"speedup\":%.2f}\n",
+      elapsed * 1e9, mb / elapsed, single / elapsed);
+
+    if (count == most) break;
+  }
+
+  stack_destroy(lexemes);
+  free(text);
+  return 0;
+}
@@ -0,0 +1,163 @@
+// Times the generated C JSON parser on 1, 2, 4 ... threads at once, to see
+// how parsing independent documents scales across cores.
+//
+//   threads [megabytes] [threads] [iterations]
+//
+// Every thread parses the same document, of the given size, from its own
+// copy of the lexemes into its own result, so the only things shared are
+// the text and the parse tables. The copy is timed along with the parse,
+// the walk over the result and freeing it. Threads default to, or with 0
+// are, the number of cores. Prints one JSON object per thread count, throughput counts the
+// bytes parsed by every thread. Built with -DPARCELR_GLR or -DPARCELR_TAPE
+// it times those parsers as bench.c does.
+//
+// The parser is built with PARCELR_CONTEXT, every parse is handed the
+// worker running it.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+struct worker;
+#define PARCELR_CONTEXT struct worker
+
+#ifdef PARCELR_GLR
+#include "glr.c"
+#define BACKEND "glr"
+#elif defined(PARCELR_TAPE)
+#include "parser.c"
+#define BACKEND "tape"
+#else
+#include "parser.c"
+#define BACKEND "c"
+#endif
+
+#include "json.h"
+
+struct worker {
+  pthread_t             thread;
+  const struct stack_s *lexemes;
+  unsigned              iterations;
+  walk                  w;
+  bool                  ok;
+};
+
+static void *work(void *arg) {
+  struct worker *worker = (struct worker*)arg;
+  struct stack_s input = stack_make(worker->lexemes->length);
+  worker->ok = true;
+
+  for (unsigned it = 0; it < worker->iterations; it++) {
+    memcpy(input.data, worker->lexemes->data, sizeof(size_t) * worker->lexemes->length);
+    input.length = worker->lexemes->length;
+
+#if defined(PARCELR_TAPE)
+    struct parser_tape value = {0};
+    bool ok = parser_parse(input, &value, worker);
+#elif defined(PARCELR_GLR)
+    json_value value = {0};
+    struct glr_forest forest;
+    bool ok = glr_parse(input, &forest, worker);
+    if (ok) glr_eval(&forest, &value, worker);
+#else
+    json_value value = {0};
+    bool ok = parser_parse(input, &value, worker);
+#endif
+    if (!ok) {
+      worker->ok = false;
+      break;
+    }
+
+    worker->w = (walk){0};
+    json_walk(value, &worker->w);
+
+#ifdef PARCELR_TAPE
+    parser_tape_destroy(&value);
+#else
+    json_free(value);
+#endif
+#ifdef PARCELR_GLR
+    glr_forest_destroy(&forest);
+#endif
+  }
+
+  stack_destroy(input);
+  return NULL;
+}
+
+// the wall time of count threads each running every iteration, -1 when a
+// parse failed or a result differs from the one of a single thread
+static double run(struct worker *workers, unsigned count, const walk *expected) {
+  double start = now();
+  for (unsigned i = 0; i < count; i++) {
+    pthread_create(&workers[i].thread, NULL, work, &workers[i]);
+  }
+  for (unsigned i = 0; i < count; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+  double elapsed = now() - start;
+
+  for (unsigned i = 0; i < count; i++) {
+    if (!workers[i].ok) return -1;
+    if (expected && (workers[i].w.count != expected->count || workers[i].w.sum != expected->sum)) return -1;
+  }
+  return elapsed;
+}
+
+int main(int argc, char **argv) {
+  size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 4;
+  unsigned most = argc > 2 ? strtoul(argv[2], NULL, 10) : 0;
+  unsigned iterations = argc > 3 ? strtoul(argv[3], NULL, 10) : 3;
+  if (most == 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    most = cores > 0 ? (unsigned)cores : 1;
+  }
+  if (iterations == 0) iterations = 1;
+
+  size_t length;
+  char *text = make_document(megabytes << 20, &length);
+
+  tokens t = { (token*)malloc(sizeof(token) * 1024), 0, 1024 };
+  if (!lex(text, length, &t)) {
+    fprintf(stderr, "could not lex document\n");
+    return 1;
+  }
+  struct stack_s lexemes = input_stack(t);
+  free(t.data);
+
+  struct worker *workers = (struct worker*)calloc(most, sizeof(struct worker));
+  for (unsigned i = 0; i < most; i++) {
+    workers[i].lexemes = &lexemes;
+    workers[i].iterations = iterations;
+  }
+
+  double single = 0;
+  walk expected = {0};
+  for (unsigned count = 1;; count = count * 2 < most ? count * 2 : most) {
+    double elapsed = run(workers, count, count == 1 ? NULL : &expected);
+    if (elapsed < 0) {
+      fprintf(stderr, "could not parse document on %u threads\n", count);
+      return 1;
+    }
+    if (count == 1) {
+      single = elapsed;
+      expected = workers[0].w;
+    }
+
+    double mb = (double)length * count * iterations / (1 << 20);
+    printf("{\"backend\":\"" BACKEND "\",\"bytes\":%zu,\"threads\":%u,\"iterations\":%u,", length, count, iterations);
+    printf("\"ns\":%.0f,\"mb_per_s\":%.1f,\"speedup\":%.2f}\n",
+      elapsed * 1e9, mb / elapsed, single * count / elapsed);
+
+    if (count == most) break;
+  }
+
+  free(workers);
+  stack_destroy(lexemes);
+  free(text);
+  return 0;
+}
@@ -0,0 +1,183 @@
+package bench
+
+// Times the generated Odin JSON parser (examples/json.txt) on a large document.
+//
+//   bench [megabytes] [iterations] [profile]
+//
+// The parser is generated into the "generated" collection by
+// bench/runtime.sh and built with PARCELR_DEBUG disabled. Lexemes of
+// examples/json.txt carry no values, so numbers and strings are only
+// scanned, not converted. Prints one JSON object. Built with
+// PARCELR_PROFILE it also reports the stack depth and writes the parser
+// profile to the given file.
+
+import "core:fmt"
+import "core:mem"
+import "core:os"
+import "core:strconv"
+import "core:strings"
+import "core:time"
+
+import "generated:parser"
+
+// the same document as bench/runtime/c, a list of nested records
+make_document :: proc(target: int) -> string {
+	sb := strings.builder_make_len_cap(0, target + 4096)
+	strings.write_byte(&sb, '[')
+	for i := 0; len(sb.buf) < target; i += 1 {
+		if i > 0 do strings.write_byte(&sb, ',')
+		fmt.sbprintf(
+			&sb,
+			"\n  {\"id\": %d, \"name\": \"item %d\", \"tags\": [\"t%d\", \"t%d\"], \"active\": %s, " +
+			"\"score\": %d.5e-1, \"parent\": null, \"nested\": {\"depth\": %d, \"values\": [%d, %d, -%d], \"empty\": {}}}",
+			i,
+			i,
+			i % 7,
+			i % 11,
+			"true" if i % 2 == 1 else "false",
+			i,
+			i % 5,
+			i,
+			i + 1,
+			i + 2,
+		)
+	}
+	strings.write_string(&sb, "\n]")
+	return strings.to_string(sb)
+}
+
+lex :: proc(text: string, out: ^[dynamic]parser.SymbolPair) -> bool {
+	i := 0
+	for i < len(text) {
+		symbol: parser.Symbol
+		switch text[i] {
+		case ' ', '\t', '\n', '\r':
+			i += 1
+			continue
+		case '{':
+			symbol = .OPEN_BRACE
+			i += 1
+		case '}':
+			symbol = .CLOSE_BRACE
+			i += 1
+		case '[':
+			symbol = .OPEN_BRACKET
+			i += 1
+		case ']':
+			symbol = .CLOSE_BRACKET
+			i += 1
+		case ',':
+			symbol = .COMMA
+			i += 1
+		case ':':
+			symbol = .COLON
+			i += 1
+		case '"':
+			end := strings.index_byte(text[i + 1:], '"')
+			if end == -1 do return false
+			symbol = .string
+			i += end + 2
+		case 't':
+			if !strings.has_prefix(text[i:], "true") do return false
+			symbol = .TRUE
+			i += 4
+		case 'f':
+			if !strings.has_prefix(text[i:], "false") do return false
+			symbol = .FALSE
+			i += 5
+		case 'n':
+			if !strings.has_prefix(text[i:], "null") do return false
+			symbol = .NULL
+			i += 4
+		case '-', '0' ..= '9':
+			for i < len(text) && strings.index_byte("-+.eE0123456789", text[i]) != -1 do i += 1
+			symbol = .number
+		case:
+			return false
+		}
+		append(out, parser.SymbolPair{symbol, {}})
+	}
+	return true
+}
+
+free_value :: proc(value: parser.Value) {
+	switch v in value {
+	case parser.Object:
+		for _, elem in v do free_value(elem)
+		delete(v)
+	case parser.Array:
+		for elem in v do free_value(elem)
+		delete(v)
+	case string, int, bool:
+	}
+}
+
+main :: proc() {
+	megabytes := 16
+	iterations := 5
+	if len(os.args) > 1 do megabytes = strconv.parse_int(os.args[1]) or_else megabytes
+	if len(os.args) > 2 do iterations = strconv.parse_int(os.args[2]) or_else iterations
+	iterations = max(iterations, 1)
+
+	text := make_document(megabytes << 20)
+	defer delete(text)
+
+	lexemes := make([dynamic]parser.SymbolPair)
+	defer delete(lexemes)
+
+	lex_best, parse_best := max(time.Duration), max(time.Duration)
+	for _ in 0 ..< iterations {
+		clear(&lexemes)
+
+		start := time.tick_now()
+		if !lex(text, &lexemes) {
+			fmt.eprintln("could not lex document")
+			os.exit(1)
+		}
+		lex_best = min(lex_best, time.tick_since(start))
+
+		start = time.tick_now()
+		value, ok := parser.parse(lexemes[:])
+		parse_best = min(parse_best, time.tick_since(start))
+
+		if !ok {
+			fmt.eprintln("could not parse document")
+			os.exit(1)
+		}
+		free_value(value)
+	}
+
+	// one more parse to count allocations, the tracking allocator is too
+	// slow to be part of the timed runs
+	track: mem.Tracking_Allocator
+	mem.tracking_allocator_init(&track, context.allocator)
+	defer mem.tracking_allocator_destroy(&track)
+	{
+		context.allocator = mem.tracking_allocator(&track)
+		value, _ := parser.parse(lexemes[:])
+		free_value(value)
+	}
+
+	tokens := f64(len(lexemes))
+	mb := f64(len(text)) / f64(1 << 20)
+	lex_s := time.duration_seconds(lex_best)
+	parse_s := time.duration_seconds(parse_best)
+
+	fmt.printf("{\"backend\":\"odin\",\"bytes\":%d,\"tokens\":%d,\"iterations\":%d,", len(text), len(lexemes), iterations)
+	fmt.printf("\"lex_ns\":%d,\"lex_tokens_per_s\":%.0f,\"lex_mb_per_s\":%.1f,", i64(lex_best), tokens / lex_s, mb / lex_s)
+	fmt.printf("\"parse_ns\":%d,\"parse_tokens_per_s\":%.0f,\"parse_mb_per_s\":%.1f,", i64(parse_best), tokens / parse_s, mb / parse_s)
+	fmt.printf("\"allocations\":%d,\"peak_bytes\":%d", track.total_allocation_count, track.peak_memory_allocated)
+	when parser.PARCELR_PROFILE {
+		fmt.printf(",\"max_depth\":%d", parser.profile.max_depth)
+		if len(os.args) > 3 {
+			fd, err := os.open(os.args[3], os.O_WRONLY | os.O_CREATE | os.O_TRUNC, 0o644)
+			if err != nil {
+				fmt.eprintln("could not write profile")
+				os.exit(1)
+			}
+			defer os.close(fd)
+			parser.profile_write(fd, parser.profile)
+		}
+	}
+	fmt.println("}")
+}
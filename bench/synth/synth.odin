@@ -0,0 +1,283 @@
+package synth
+
+// Writes a synthetic grammar to stdout, LALR(1) by construction except for
+// the operator and dangling patterns.
+//
+// Terminals are split into openers, closers and separators. Every
+// production of a nonterminal starts with its own opener and ends with a
+// closer, so no production is a prefix of another and every nonterminal
+// reference is delimited. Nonterminals are laid out in layers, each layer
+// only refers to the next one, so the nesting depth of the grammar equals
+// the depth parameter.
+
+import "core:fmt"
+import "core:os"
+import "core:strconv"
+import "core:strings"
+
+Pattern :: enum {
+	Plain, // a single reference to a nonterminal of the next layer
+	Left, // left recursive separated list
+	Right, // right recursive separated list
+	Optional, // reference that may be empty
+	Prefix, // productions sharing a long prefix, decided by the closer
+	Expr, // layered binary expressions, one level per depth
+	Mixed, // any of the above
+
+	// ambiguous, so never picked by mixed
+	Operator, // h -> h s h, resolved by declaring s %left
+	Dangling, // if-then-else like, left for parcelr --glr
+}
+
+PATTERN_NAMES := [Pattern]string {
+	.Plain    = "plain",
+	.Left     = "left",
+	.Right    = "right",
+	.Optional = "optional",
+	.Prefix   = "prefix",
+	.Expr     = "expr",
+	.Mixed    = "mixed",
+	.Operator = "operator",
+	.Dangling = "dangling",
+}
+
+Options :: struct {
+	rules:     int,
+	terminals: int,
+	depth:     int,
+	seed:      u64,
+	pattern:   Pattern,
+}
+
+USAGE :: `synth [--rules=N] [--terminals=N] [--depth=N] [--seed=N] [--pattern=NAME]
+
+patterns: plain, left, right, optional, prefix, expr, mixed, operator, dangling`
+
+// parcelr lookaheads hold at most 128 lexemes, two of which are EOF and ERR
+MAX_TERMINALS :: 126
+
+// xorshift64*, so the output only depends on the seed
+Random :: struct {
+	state: u64,
+}
+
+next :: proc(r: ^Random, n: int) -> int {
+	r.state ~= r.state >> 12
+	r.state ~= r.state << 25
+	r.state ~= r.state >> 27
+	return int((r.state * 0x2545F4914F6CDD1D) >> 33) % n
+}
+
+Synth :: struct {
+	using opts: Options,
+	sb:         strings.Builder,
+	extra:      strings.Builder, // helper nonterminals, written after the layers
+	random:     Random,
+	openers:    int,
+	closers:    int,
+	separators: int,
+	helpers:    int,
+	exprs:      bool, // whether any production refers to e0
+}
+
+parse_options :: proc(args: []string) -> (opts: Options, ok: bool) {
+	opts = {
+		rules     = 100,
+		terminals = 32,
+		depth     = 4,
+		seed      = 1,
+		pattern   = .Mixed,
+	}
+
+	for arg in args {
+		eq := strings.index_byte(arg, '=')
+		if eq == -1 do return opts, false
+		key, value := arg[:eq], arg[eq + 1:]
+
+		switch key {
+		case "--rules":
+			opts.rules = strconv.parse_int(value) or_return
+		case "--terminals":
+			opts.terminals = strconv.parse_int(value) or_return
+		case "--depth":
+			opts.depth = strconv.parse_int(value) or_return
+		case "--seed":
+			opts.seed = strconv.parse_u64(value) or_return
+		case "--pattern":
+			found := false
+			for name, pattern in PATTERN_NAMES {
+				if name == value {
+					opts.pattern = pattern
+					found = true
+				}
+			}
+			if !found do return opts, false
+		case:
+			return opts, false
+		}
+	}
+
+	opts.rules = max(opts.rules, 1)
+	opts.depth = max(opts.depth, 1)
+	opts.terminals = clamp(opts.terminals, 8, MAX_TERMINALS)
+	return opts, true
+}
+
+main :: proc() {
+	opts, ok := parse_options(os.args[1:])
+	if !ok {
+		fmt.eprintln(USAGE)
+		os.exit(1)
+	}
+
+	s := Synth {
+		opts       = opts,
+		sb         = strings.builder_make(),
+		extra      = strings.builder_make(),
+		random     = {opts.seed * 0x9E3779B97F4A7C15 | 1},
+		closers    = opts.terminals / 4,
+		separators = opts.terminals / 8,
+	}
+	s.openers = s.terminals - s.closers - s.separators
+	defer strings.builder_destroy(&s.sb)
+	defer strings.builder_destroy(&s.extra)
+
+	write_grammar(&s)
+	fmt.print(strings.to_string(s.sb))
+}
+
+write_grammar :: proc(s: ^Synth) {
+	// on average three productions per nonterminal, n0 alone forms the
+	// first layer and refers to every nonterminal of the second one
+	count := max(s.rules / 3, 2)
+	layers := min(s.depth, count - 1)
+	per_layer := max((count - 1 + layers - 1) / layers, 1)
+
+	layer_start :: proc(layer, layers, per_layer, count: int) -> int {
+		if layer == 0 do return 0
+		if layer > layers do return count
+		return min(1 + (layer - 1) * per_layer, count)
+	}
+
+	fmt.sbprintf(&s.sb, "# synth --rules=%d --terminals=%d --depth=%d --seed=%d --pattern=%s\n\n", s.rules, s.terminals, s.depth, s.seed, PATTERN_NAMES[s.pattern])
+
+	// round robin over the next layer so every nonterminal is reachable
+	next_ref := 0
+	produced := 0
+	for n in 0 ..< count {
+		layer := 0 if n == 0 else min((n - 1) / per_layer, layers - 1) + 1
+		next_from := layer_start(layer + 1, layers, per_layer, count)
+		next_to := layer_start(layer + 2, layers, per_layer, count)
+
+		alts := clamp(s.rules / count + int(n < s.rules % count), 1, s.openers)
+		if n == count - 1 do alts = clamp(s.rules - produced, 1, s.openers)
+		produced += alts
+
+		fmt.sbprintf(&s.sb, "n%d\n", n)
+		for alt in 0 ..< alts {
+			opener := (n * 7 + alt) % s.openers
+			body := strings.builder_make(context.temp_allocator)
+			fmt.sbprintf(&body, "o%d", opener)
+
+			if n == 0 && alt == 0 {
+				for target in next_from ..< next_to do fmt.sbprintf(&body, " n%d", target)
+			} else {
+				elems := 1 + next(&s.random, 3)
+				for e in 0 ..< elems {
+					if next_to > next_from && (e == 0 || next(&s.random, 10) < 6) {
+						target := next_from + next_ref % (next_to - next_from)
+						next_ref += 1
+						write_reference(s, &body, target)
+					} else {
+						fmt.sbprintf(&body, " %s", terminal(s, next(&s.random, s.terminals)))
+					}
+				}
+			}
+
+			pattern := s.pattern
+			if pattern == .Mixed do pattern = Pattern(next(&s.random, int(Pattern.Mixed)))
+			closer := next(&s.random, s.closers)
+			fmt.sbprintf(&s.sb, " -> %s c%d\n", strings.to_string(body), closer)
+			if pattern == .Prefix && s.closers > 1 {
+				fmt.sbprintf(&s.sb, " -> %s c%d\n", strings.to_string(body), (closer + 1) % s.closers)
+			}
+		}
+		fmt.sbprint(&s.sb, ";\n")
+	}
+
+	fmt.sbprint(&s.sb, strings.to_string(s.extra))
+	if s.exprs do write_expr(s)
+
+	free_all(context.temp_allocator)
+}
+
+terminal :: proc(s: ^Synth, i: int) -> string {
+	if i < s.openers do return fmt.tprintf("o%d", i)
+	if i < s.openers + s.closers do return fmt.tprintf("c%d", i - s.openers)
+	return fmt.tprintf("s%d", i - s.openers - s.closers)
+}
+
+// writes a reference to nonterminal n into body, lists and optionals get
+// their own helper nonterminal and are always followed by a closer
+write_reference :: proc(s: ^Synth, body: ^strings.Builder, n: int) {
+	pattern := s.pattern
+	if pattern == .Mixed do pattern = Pattern(next(&s.random, int(Pattern.Mixed)))
+	if s.separators == 0 && pattern in bit_set[Pattern]{.Left, .Right, .Operator, .Dangling} do pattern = .Plain
+
+	helper := s.helpers
+	switch pattern {
+	case .Plain, .Prefix:
+		fmt.sbprintf(body, " n%d", n)
+		return
+	case .Expr:
+		s.exprs = true
+		fmt.sbprintf(body, " n%d e0 c%d", n, next(&s.random, s.closers))
+		return
+	case .Left:
+		sep := next(&s.random, s.separators)
+		fmt.sbprintf(&s.extra, "h%d\n -> h%d s%d n%d\n -> n%d\n;\n", helper, helper, sep, n, n)
+	case .Right:
+		sep := next(&s.random, s.separators)
+		fmt.sbprintf(&s.extra, "h%d\n -> n%d s%d h%d\n -> n%d\n;\n", helper, n, sep, helper, n)
+	case .Optional:
+		fmt.sbprintf(&s.extra, "h%d\n -> n%d\n ->\n;\n", helper, n)
+	case .Operator:
+		// a shift/reduce conflict on s in every h s h s h, which the
+		// declaration resolves as h s h reduced first
+		sep := next(&s.random, s.separators)
+		fmt.sbprintf(&s.extra, "%%left s%d ;\nh%d\n -> h%d s%d h%d\n -> n%d\n;\n", sep, helper, helper, sep, helper, n)
+	case .Dangling:
+		// o n o n h s h, the s can close either o, nothing declared
+		opener := next(&s.random, s.openers)
+		sep := next(&s.random, s.separators)
+		fmt.sbprintf(
+			&s.extra,
+			"h%d\n -> o%d n%d h%d\n -> o%d n%d h%d s%d h%d\n -> n%d\n;\n",
+			helper,
+			opener,
+			n,
+			helper,
+			opener,
+			n,
+			helper,
+			sep,
+			helper,
+			n,
+		)
+	case .Mixed:
+		unreachable()
+	}
+	s.helpers += 1
+	fmt.sbprintf(body, " h%d c%d", helper, next(&s.random, s.closers))
+}
+
+// e0 -> e0 s0 e1 -> e1 ; e1 -> e1 s1 e2 -> e2 ; ... ; eN -> o0 e0 c0 -> o1 ;
+// every level gets its own operator, so there are at most as many levels
+// as there are separators
+write_expr :: proc(s: ^Synth) {
+	levels := min(s.depth, s.separators)
+	for level in 0 ..< levels {
+		fmt.sbprintf(&s.sb, "e%d\n -> e%d s%d e%d\n -> e%d\n;\n", level, level, level, level + 1, level + 1)
+	}
+	fmt.sbprintf(&s.sb, "e%d\n -> o0 e0 c0\n -> o1\n;\n", levels)
+}
@@ -0,0 +1,103 @@
+#!/bin/sh
+# Times the generated C JSON parsers on 1, 2, 4 ... threads at once.
+# The split backend instead parses one newline delimited document with
+# parser_parse_split on that many threads, see bench/runtime/c/lines.c.
+#
+#   bench/threads.sh [results.jsonl]
+#
+# Environment:
+#   TEMPLATES   directory holding the c/ template set              (templates)
+#   LABEL       name recorded next to the results                  (basename of TEMPLATES)
+#   ANALYSER    analyser used to generate the parsers              (LALR1)
+#   BACKENDS    backends to run, as for bench/runtime.sh, or split (c tape)
+#   THREADS     most threads run at once, 0 for one per core       (0)
+#   MEGABYTES   size of the document every thread parses           (4)
+#   ITERATIONS  parses per thread                                  (3)
+#   CC, CFLAGS  C compiler and flags                               (cc, -O2)
+#   TSAN        set to 1 to build with ThreadSanitizer instead and
+#               fail on the first report, on a 1 MB document
+#
+# Throughput should grow with the threads up to the number of cores, the
+# speedup column is relative to a single thread.
+
+set -e
+cd "$(dirname "$0")/.."
+
+TEMPLATES=${TEMPLATES:-templates}
+LABEL=${LABEL:-$(basename "$TEMPLATES")}
+ANALYSER=${ANALYSER:-LALR1}
+BACKENDS=${BACKENDS:-"c tape"}
+THREADS=${THREADS:-0}
+MEGABYTES=${MEGABYTES:-4}
+ITERATIONS=${ITERATIONS:-3}
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:-"-O2"}
+TSAN=${TSAN:-0}
+
+BUILD=bench/build/threads/$LABEL
+RESULTS=${1:-bench/build/threads.jsonl}
+
+if [ "$TSAN" = 1 ]; then
+	CFLAGS="$CFLAGS -g -fsanitize=thread"
+	MEGABYTES=1
+	ITERATIONS=1
+	export TSAN_OPTIONS="halt_on_error=1 exitcode=66 $TSAN_OPTIONS"
+fi
+
+mkdir -p $BUILD
+odin build . -o:speed -out:bench/build/parcelr
+
+# first number following the given key
+json_num() {
+	printf '%s\n' "$2" | awk -v k="$1" '{ i = index($0, k); if (i == 0) next; s = substr($0, i + length(k)); sub(/[^0-9.].*/, "", s); print s }'
+}
+
+printf '%-12s %-5s %8s %10s %10s %8s\n' label back threads ms MB/s speedup
+
+for backend in $BACKENDS; do
+	mkdir -p $BUILD/$backend
+	case $backend in
+	c)
+		bench/build/parcelr --quiet $ANALYSER examples/json_c.txt $BUILD/c \
+			$TEMPLATES/c/parser.h $TEMPLATES/c/parser.c $TEMPLATES/c/stack.h
+		cp examples/c/array.h examples/c/hashmap.h examples/c/swisstable.h examples/c/json_value.h $BUILD/c
+		flags=
+		source=threads.c
+		;;
+	glr)
+		bench/build/parcelr --quiet --glr $ANALYSER examples/json_c.txt $BUILD/glr \
+			$TEMPLATES/c/parser.h $TEMPLATES/c/glr.h $TEMPLATES/c/glr.c $TEMPLATES/c/stack.h
+		cp examples/c/array.h examples/c/hashmap.h examples/c/swisstable.h examples/c/json_value.h $BUILD/glr
+		flags=-DPARCELR_GLR
+		source=threads.c
+		;;
+	tape)
+		bench/build/parcelr --quiet $ANALYSER examples/json_tape_c.txt $BUILD/tape \
+			$TEMPLATES/c/parser.h $TEMPLATES/c/parser.c $TEMPLATES/c/stack.h
+		flags=-DPARCELR_TAPE
+		source=threads.c
+		;;
+	split)
+		bench/build/parcelr --quiet $ANALYSER examples/json_lines_c.txt $BUILD/split \
+			$TEMPLATES/c/parser.h $TEMPLATES/c/parser.c $TEMPLATES/c/split.c $TEMPLATES/c/stack.h
+		cp examples/c/array.h examples/c/hashmap.h examples/c/swisstable.h examples/c/json_value.h $BUILD/split
+		flags=
+		source=lines.c
+		;;
+	*)
+		echo "unknown backend: $backend" >&2
+		exit 1
+		;;
+	esac
+	$CC $CFLAGS $flags -I$BUILD/$backend bench/runtime/c/$source -o $BUILD/threads_$backend -lpthread
+
+	results=$($BUILD/threads_$backend $MEGABYTES $THREADS $ITERATIONS)
+	printf '%s\n' "$results" | while read -r result; do
+		printf '{"label":"%s","analyser":"%s","result":%s}\n' "$LABEL" $ANALYSER "$result" >> "$RESULTS"
+		printf '%-12s %-5s %8s %10s %10s %8s\n' "$LABEL" $backend \
+			$(json_num '"threads":' "$result") \
+			$(awk -v ns=$(json_num '"ns":' "$result") 'BEGIN { printf "%.2f", ns / 1000000 }') \
+			$(json_num '"mb_per_s":' "$result") \
+			$(json_num '"speedup":' "$result")
+	done
+done
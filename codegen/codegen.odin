@@ -1,6 +1,7 @@
 package codegen
 
 import "core:fmt"
+import "core:slice"
 import "core:strings"
 
 import "../grammar"
@@ -10,6 +11,50 @@ Globals :: struct {
 	rule:     []ReduceVal,
 	symbol:   []Symbol,
 	preamble: string,
+	type:     []string, // distinct symbol types, in order of appearance
+	split:    []SplitVal, // the %split of the grammar, empty without
+
+	// bits of the narrowest unsigned integer holding every state, symbol or
+	// rule
+	state_width:  int,
+	symbol_width: int,
+	rule_width:   int,
+
+	// bit i of word i / 32 is set when state i has an action on error
+	error_mask: []int,
+
+	// dense tables for table driven templates, one row per state: an action
+	// is 0 on error, s + 1 to shift to state s, -(r + 1) to reduce by rule r
+	// and -(len(rule) + 1) to accept, a goto is 0 or s + 1
+	action_table: []int, // a column per lexeme, see symbol.column
+	goto_table:   []int, // a column per nonterminal
+	action_width: int,
+	goto_width:   int,
+	rule_lhs:     []int, // position of the lhs in the symbol global, per rule
+	rule_length:  []int,
+}
+
+// everything a template can read, built once by make_context and never
+// written to by eval, so one context can be shared by several evaluations
+// running at the same time
+Context :: struct {
+	using globals: Globals,
+	symbols:       []Symbol, // indexed by grammar.Symbol, the symbol global without ROOT
+	first:         [][]Symbol, // lexemes, per symbol
+	follow:        [][]Symbol,
+	type_index:    []int, // position in the type global per symbol, -1 without a type
+	column:        []int, // column in the action or goto table per symbol
+}
+
+width :: proc(count: int) -> int {
+	switch {
+	case count <= 1 << 8:
+		return 8
+	case count <= 1 << 16:
+		return 16
+	case:
+		return 32
+	}
 }
 
 make_single :: proc(e: $E) -> []E {
@@ -18,33 +63,156 @@ make_single :: proc(e: $E) -> []E {
 	return s
 }
 
-make_globals :: proc(g: grammar.Grammar, table: grammar.Table) -> Globals {
-	globals := Globals {
-		make([]StateVal, len(table)),
-		make([]ReduceVal, len(g.rules) - 1),
-		g.symbols[1:],
-		g.preamble,
+// the lexemes in a lookahead, in lexeme order
+lexeme_list :: proc(g: grammar.Grammar, symbols: []Symbol, lah: grammar.Lookahead) -> []Symbol {
+	list := make([]Symbol, card(lah))
+	i := 0
+	for lexeme in lah {
+		list[i] = symbols[g.lexemes[lexeme]]
+		i += 1
+	}
+	return list
+}
+
+make_context :: proc(
+	g: grammar.Grammar,
+	table: grammar.Table,
+	first: []grammar.Lookahead,
+	follow: []grammar.Lookahead,
+	profile := grammar.Profile{},
+	conflicts := grammar.Conflicts{},
+) -> Context {
+	symbols := make([]Symbol, len(g.symbols))
+	for def, i in g.symbols {
+		symbols[i] = {def, grammar.Symbol(i)}
+	}
+
+	ctx := Context {
+		globals = Globals {
+			make([]StateVal, len(table)),
+			make([]ReduceVal, len(g.rules) - 1),
+			symbols[1:],
+			g.preamble,
+			nil,
+			nil,
+			width(len(table)),
+			width(len(g.symbols) - 1),
+			width(len(g.rules) - 1),
+			make([]int, (len(table) + 31) / 32),
+		},
+		symbols = symbols,
+		first = make([][]Symbol, len(g.symbols)),
+		follow = make([][]Symbol, len(g.symbols)),
+		type_index = make([]int, len(g.symbols)),
+		column = make([]int, len(g.symbols)),
+	}
+	globals := &ctx.globals
+
+	for i in 0 ..< len(g.symbols) {
+		ctx.first[i] = lexeme_list(g, symbols, first[i])
+		ctx.follow[i] = lexeme_list(g, symbols, follow[i])
+	}
+
+	// the symbol each state is entered on, states reached through a
+	// bypassed unit rule are entered on symbols of the same type
+	entry := make([]grammar.Symbol, len(table))
+	defer delete(entry)
+	for row in table {
+		for symbol, decision in row {
+			if shift, ok := decision.(grammar.Shift); ok && entry[shift] == grammar.ROOT {
+				entry[shift] = symbol
+			}
+		}
+	}
+
+	err := g.lexemes[grammar.ERR]
+	for row, i in table {
+		if err in row do globals.error_mask[i / 32] |= 1 << uint(i % 32)
+	}
+
+	type := make([dynamic]string)
+	for symbol in g.symbols[1:] {
+		if symbol.type != {} && !slice.contains(type[:], symbol.type) {
+			append(&type, symbol.type)
+		}
+	}
+	globals.type = type[:]
+
+	for symbol, i in g.symbols {
+		ctx.type_index[i] = -1
+		if symbol.type == {} do continue
+		if k, found := slice.linear_search(globals.type, symbol.type); found {
+			ctx.type_index[i] = k
+		}
+	}
+
+	if g.split.list != grammar.ROOT {
+		globals.split = make_single(SplitVal{symbols[g.split.list], symbols[g.split.separator], g.split.code})
 	}
 
 	for rule, i in g.rules[1:] {
-		lhs := g.symbols[rule.lhs]
+		lhs := symbols[rule.lhs]
 		rhs := make([]Symbol, len(rule.rhs))
 		for k in 0 ..< len(rhs) {
-			rhs[k] = g.symbols[rule.rhs[k]]
+			rhs[k] = symbols[rule.rhs[k]]
 		}
-		globals.rule[i] = ReduceVal{lhs, rhs, rule.code}
+		globals.rule[i] = ReduceVal{lhs, rhs, rule.code, i}
+	}
+
+	for lexeme, k in g.lexemes {
+		ctx.column[lexeme] = k
+	}
+	for symbol, i in g.symbols[1:] {
+		if symbol.lexeme do continue
+		ctx.column[i + 1] = globals.goto_width
+		globals.goto_width += 1
+	}
+	globals.action_width = len(g.lexemes)
+	globals.action_table = make([]int, len(table) * globals.action_width)
+	globals.goto_table = make([]int, len(table) * globals.goto_width)
+	for row, i in table {
+		for symbol, decision in row {
+			column := ctx.column[symbol]
+			switch v in decision {
+			case grammar.Shift:
+				if g.symbols[symbol].lexeme {
+					globals.action_table[i * globals.action_width + column] = int(v) + 1
+				} else {
+					globals.goto_table[i * globals.goto_width + column] = int(v) + 1
+				}
+			case grammar.Reduce:
+				if !g.symbols[symbol].lexeme do continue
+				r := int(v) - 1 if v != grammar.Reduce(grammar.START) else len(globals.rule)
+				globals.action_table[i * globals.action_width + column] = -(r + 1)
+			}
+		}
+	}
+
+	globals.rule_lhs = make([]int, len(globals.rule))
+	globals.rule_length = make([]int, len(globals.rule))
+	for rule, i in g.rules[1:] {
+		globals.rule_lhs[i] = int(rule.lhs) - 1
+		globals.rule_length[i] = len(rule.rhs)
+	}
+
+	// lookaheads on nonterminals only ever shift, they are kept apart from
+	// lexemes for templates with a separate goto step
+	Key :: struct {
+		decision: grammar.Decision,
+		lexeme:   bool,
 	}
 
 	for i in 0 ..< len(table) {
-		lookup := make(map[grammar.Decision]int)
+		lookup := make(map[Key]int)
 		defer delete(lookup)
 		lah := make([dynamic]LookaheadVal)
 
 		for symbol, decision in table[i] {
-			if k, ok := lookup[decision]; ok {
+			key := Key{decision, g.symbols[symbol].lexeme}
+			if k, ok := lookup[key]; ok {
 				clone := make([]Symbol, len(lah[k].symbol) + 1)
 				copy(clone, lah[k].symbol)
-				clone[len(clone) - 1] = g.symbols[symbol]
+				clone[len(clone) - 1] = symbols[symbol]
 
 				delete(lah[k].symbol)
 				lah[k].symbol = clone
@@ -52,8 +220,8 @@ make_globals :: proc(g: grammar.Grammar, table: grammar.Table) -> Globals {
 			}
 
 			j := len(lah)
-			lookup[decision] = j
-			append(&lah, LookaheadVal{make_single(g.symbols[symbol]), nil, nil, nil})
+			lookup[key] = j
+			append(&lah, LookaheadVal{make_single(symbols[symbol]), nil, nil, nil})
 
 			switch v in decision {
 			case grammar.Reduce:
@@ -67,9 +235,80 @@ make_globals :: proc(g: grammar.Grammar, table: grammar.Table) -> Globals {
 			}
 		}
 
-		globals.state[i] = {i, lah[:]}
+		// most frequent decisions first when there is a profile, shifts
+		// are weighed by the visits of their target state
+		if profile.states != nil {
+			weight :: proc(l: LookaheadVal, p: grammar.Profile) -> int {
+				if len(l.shift) > 0 do return p.states[l.shift[0]]
+				if len(l.reduce) > 0 do return p.rules[l.reduce[0].index]
+				return 0
+			}
+
+			for k in 1 ..< len(lah) {
+				for m := k; m > 0 && weight(lah[m], profile) > weight(lah[m - 1], profile); m -= 1 {
+					lah[m], lah[m - 1] = lah[m - 1], lah[m]
+				}
+			}
+		}
+
+		action := make([dynamic]LookaheadVal)
+		goto := make([dynamic]LookaheadVal)
+		for l in lah {
+			if l.symbol[0].lexeme {
+				append(&action, l)
+			} else {
+				append(&goto, l)
+			}
+		}
+
+		// conflicts are only kept for lexemes, so no grouping is needed
+		conflict := make([dynamic]LookaheadVal)
+		for symbol in table[i] {
+			decisions, found := conflicts[grammar.Cell{i, symbol}]
+			if !found do continue
+
+			l := LookaheadVal{make_single(symbols[symbol]), nil, nil, nil}
+			reduce := make([dynamic]ReduceVal)
+			for decision in decisions {
+				if v, ok := decision.(grammar.Reduce); ok {
+					if v == grammar.Reduce(grammar.START) {
+						l.accept = {{}}
+					} else {
+						append(&reduce, globals.rule[v - 1])
+					}
+				}
+			}
+			l.reduce = reduce[:]
+			append(&conflict, l)
+		}
+
+		id := profile.ids[i] if profile.ids != nil else i
+		enter: []Symbol
+		if entry[i] != grammar.ROOT do enter = make_single(symbols[entry[i]])
+		globals.state[i] = {i, id, lah[:], action[:], goto[:], enter, conflict[:]}
 	}
-	return globals
+	return ctx
+}
+
+delete_context :: proc(ctx: Context) {
+	delete_value(ctx.state)
+	delete_value(ctx.rule)
+	delete(ctx.type)
+	delete(ctx.split)
+	delete(ctx.error_mask)
+	for i in 0 ..< len(ctx.symbols) {
+		delete(ctx.first[i])
+		delete(ctx.follow[i])
+	}
+	delete(ctx.first)
+	delete(ctx.follow)
+	delete(ctx.type_index)
+	delete(ctx.column)
+	delete(ctx.action_table)
+	delete(ctx.goto_table)
+	delete(ctx.rule_lhs)
+	delete(ctx.rule_length)
+	delete(ctx.symbols)
 }
 
 StackElement :: struct {
@@ -77,59 +316,54 @@ StackElement :: struct {
 	value: Value,
 }
 
-get_value :: proc(var: Var, stack: []StackElement) -> (value: Value, ok: bool) {
+// the value is owned by the caller when owned is set
+get_value :: proc(
+	ctx: Context,
+	var: Var,
+	stack: []StackElement,
+) -> (
+	value: Value,
+	owned: bool,
+	ok: bool,
+) {
 	for i := len(stack) - 1; i >= 0; i -= 1 {
 		if var[0] != stack[i].var do continue
 
 		value = stack[i].value
-		for s, i in var[1:] {
-			parent := value
-			defer if i > 0 do delete_value_slice(parent)
-			value = get_child(value, s) or_return
+		for s in var[1:] {
+			parent, parent_owned := value, owned
+			defer if parent_owned do delete_value_slice(parent)
+			value, owned = get_child(ctx, parent, s) or_return
 		}
-		return value, true
+		return value, owned, true
 	}
-	return {}, false
+	return {}, false, false
 }
 
-eval :: proc(
-	directives: []Directive,
-	g: grammar.Grammar,
-	table: grammar.Table,
-	follow: []grammar.Lookahead,
-) -> (
-	string,
-	bool,
-) {
-	globals := make_globals(g, table)
-
+eval :: proc(directives: []Directive, ctx: Context) -> (string, bool) {
 	stack := make([dynamic]StackElement)
-	append(&stack, StackElement{"state", globals.state})
-	append(&stack, StackElement{"symbol", globals.symbol})
-	append(&stack, StackElement{"preamble", globals.preamble})
-	append(&stack, StackElement{"rule", globals.rule})
-
-	defer {
-		delete_value(stack[0].value)
-		// delete_value(stack[1].value) // do note delete, directly taken from Grammar
-		delete_value(stack[2].value)
-		delete_value(stack[3].value)
-		delete(stack)
-	}
-
-	// set up follow sets
-	symbols = g.symbols
-	lexemes = g.lexemes
-	follow_sets = make(map[string]grammar.Lookahead)
-	for lah, i in follow {
-		follow_sets[g.symbols[i].name] = lah
-	}
-	defer delete(follow_sets)
+	defer delete(stack)
+	append(&stack, StackElement{"state", ctx.state})
+	append(&stack, StackElement{"symbol", ctx.symbol})
+	append(&stack, StackElement{"preamble", ctx.preamble})
+	append(&stack, StackElement{"rule", ctx.rule})
+	append(&stack, StackElement{"type", ctx.type})
+	append(&stack, StackElement{"split", ctx.split})
+	append(&stack, StackElement{"state_width", ctx.state_width})
+	append(&stack, StackElement{"symbol_width", ctx.symbol_width})
+	append(&stack, StackElement{"rule_width", ctx.rule_width})
+	append(&stack, StackElement{"error_mask", ctx.error_mask})
+	append(&stack, StackElement{"action_table", ctx.action_table})
+	append(&stack, StackElement{"goto_table", ctx.goto_table})
+	append(&stack, StackElement{"action_width", ctx.action_width})
+	append(&stack, StackElement{"goto_width", ctx.goto_width})
+	append(&stack, StackElement{"rule_lhs", ctx.rule_lhs})
+	append(&stack, StackElement{"rule_length", ctx.rule_length})
 
 	sb := strings.builder_make_none()
 
 	dirs := directives
-	ok := _eval(&sb, &stack, &dirs, false)
+	ok := _eval(ctx, &sb, &stack, &dirs, false)
 	if !ok {
 		strings.builder_destroy(&sb)
 		return {}, false
@@ -152,6 +386,7 @@ _skip :: proc(directives: ^[]Directive) -> bool {
 }
 
 _eval :: proc(
+	ctx: Context,
 	sb: ^strings.Builder,
 	stack: ^[dynamic]StackElement,
 	directives: ^[]Directive,
@@ -180,24 +415,30 @@ _eval :: proc(
 
 			fmt.sbprint(sb, v.after)
 			for varlit in v.vars {
-				val := get_value(varlit.var, stack[:]) or_return
-				defer if len(varlit.var) > 1 do delete_value_slice(val)
+				val, owned := get_value(ctx, varlit.var, stack[:]) or_return
+				defer if owned do delete_value_slice(val)
 
 				print_value(sb, val) or_return
 				fmt.sbprint(sb, varlit.lit)
 			}
 		case Start:
-			val := get_value(v.var, stack[:]) or_return
-			defer if len(v.var) > 1 do delete_value_slice(val)
+			// a trailing reversed walks the list backwards instead of copying it
+			var := v.var
+			backwards := len(var) > 1 && var[len(var) - 1] == "reversed"
+			if backwards do var = var[:len(var) - 1]
+
+			val, owned := get_value(ctx, var, stack[:]) or_return
+			defer if owned do delete_value_slice(val)
 
-			it, _ := as_slice(val, true)
+			it := as_slice(val, !backwards) or_return
+			it.reversed = backwards
 			for val, idx in iterate_values(&it) {
 				append(stack, StackElement{v.name, val})
 				if v.index != {} do append(stack, StackElement{v.index, idx})
 				if v.reversed_index != {} do append(stack, StackElement{v.reversed_index, it.len - idx - 1})
 
 				dirs := directives^
-				_eval(sb, stack, &dirs, idx == it.len - 1) or_return
+				_eval(ctx, sb, stack, &dirs, idx == it.len - 1) or_return
 
 				if v.reversed_index != {} do pop(stack)
 				if v.index != {} do pop(stack)
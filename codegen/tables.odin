@@ -0,0 +1,116 @@
+package codegen
+
+import "core:mem"
+
+// the file written by --emit-tables and read by templates/c/tables.c, made
+// of little endian 32 bit words:
+//
+//   header        magic, version, states, lexemes, nonterminals, symbols,
+//                 rules, action rows, goto rows, bytes of names
+//   column        [symbols]                column of each symbol in its table
+//   lexeme        [symbols]                1 for lexemes, 0 for nonterminals
+//   action index  [states]                 action row of each state
+//   action        [action rows * lexemes]
+//   goto index    [states]
+//   goto          [goto rows * nonterminals]
+//   rule lhs      [rules]
+//   rule length   [rules]
+//   name offset   [symbols]                into the names
+//   names                                  NUL terminated, padded to a word
+//
+// symbols and rules are numbered as in the symbol and rule globals, cells
+// are encoded as in action_table and goto_table, and states sharing a row
+// share its storage
+TABLES_MAGIC :: 0x524c4350 // "PCLR"
+TABLES_VERSION :: 2
+
+// rows of a dense table with identical rows stored once
+Rows :: struct {
+	index: []int, // row per state
+	cells: [dynamic]int,
+	count: int,
+}
+
+dedup_rows :: proc(table: []int, width, states: int) -> Rows {
+	rows := Rows{make([]int, states), make([dynamic]int), 0}
+
+	// keyed by the bytes of the row, which stay in the context
+	seen := make(map[string]int)
+	defer delete(seen)
+
+	for i in 0 ..< states {
+		row := table[i * width:(i + 1) * width]
+		key := transmute(string)mem.slice_to_bytes(row)
+		if k, ok := seen[key]; ok {
+			rows.index[i] = k
+			continue
+		}
+		seen[key] = rows.count
+		rows.index[i] = rows.count
+		rows.count += 1
+		append(&rows.cells, ..row)
+	}
+	return rows
+}
+
+write_tables :: proc(ctx: Context) -> []u8 {
+	put :: proc(buf: ^[dynamic]u8, words: ..int) {
+		for word in words {
+			w := u32(i32(word))
+			append(buf, u8(w), u8(w >> 8), u8(w >> 16), u8(w >> 24))
+		}
+	}
+
+	states := len(ctx.state)
+	action := dedup_rows(ctx.action_table, ctx.action_width, states)
+	defer {
+		delete(action.index)
+		delete(action.cells)
+	}
+	goto := dedup_rows(ctx.goto_table, ctx.goto_width, states)
+	defer {
+		delete(goto.index)
+		delete(goto.cells)
+	}
+
+	names := make([dynamic]u8)
+	defer delete(names)
+	offset := make([]int, len(ctx.symbol))
+	defer delete(offset)
+	for symbol, i in ctx.symbol {
+		offset[i] = len(names)
+		append(&names, symbol.name)
+		append(&names, 0)
+	}
+	for len(names) % 4 != 0 do append(&names, 0)
+
+	buf := make([dynamic]u8)
+	put(
+		&buf,
+		TABLES_MAGIC,
+		TABLES_VERSION,
+		states,
+		ctx.action_width,
+		ctx.goto_width,
+		len(ctx.symbol),
+		len(ctx.rule),
+		action.count,
+		goto.count,
+		len(names),
+	)
+	for symbol in ctx.symbol {
+		put(&buf, ctx.column[symbol.index])
+	}
+	for symbol in ctx.symbol {
+		put(&buf, int(symbol.lexeme))
+	}
+	put(&buf, ..action.index)
+	put(&buf, ..action.cells[:])
+	put(&buf, ..goto.index)
+	put(&buf, ..goto.cells[:])
+	put(&buf, ..ctx.rule_lhs)
+	put(&buf, ..ctx.rule_length)
+	put(&buf, ..offset)
+	append(&buf, ..names[:])
+	return buf[:]
+}
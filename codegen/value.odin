@@ -7,7 +7,12 @@ import "core:strings"
 
 import "../grammar"
 
-Symbol :: grammar.SymbolDefinition
+// a symbol of the grammar, the index finds its sets in the Context
+Symbol :: struct {
+	using definition: grammar.SymbolDefinition,
+	index:            grammar.Symbol,
+}
+
 void :: struct {}
 
 LookaheadVal :: struct {
@@ -18,14 +23,28 @@ LookaheadVal :: struct {
 }
 
 ReduceVal :: struct {
-	lhs:  Symbol,
-	rhs:  []Symbol,
-	code: string,
+	lhs:   Symbol,
+	rhs:   []Symbol,
+	code:  string,
+	index: int, // position in the rule global
+}
+
+// the %split of the grammar, the code merges the value of a piece, _1, into
+// the value of the pieces before it, _0
+SplitVal :: struct {
+	list:      Symbol,
+	separator: Symbol,
+	code:      string,
 }
 
 StateVal :: struct {
 	index:     int,
+	id:        int, // index given by the analyser, before any renumbering
 	lookahead: []LookaheadVal,
+	action:    []LookaheadVal, // lookahead on lexemes
+	goto:      []LookaheadVal, // lookahead on nonterminals
+	entry:     []Symbol, // symbol the state is entered on, none for the start state
+	conflict:  []LookaheadVal, // decisions the table left out, one lexeme each
 }
 
 Value :: union #no_nil {
@@ -35,6 +54,7 @@ Value :: union #no_nil {
 	LookaheadVal,
 	ReduceVal,
 	StateVal,
+	SplitVal,
 	Symbol,
 	[]void,
 	[]int,
@@ -42,117 +62,139 @@ Value :: union #no_nil {
 	[]LookaheadVal,
 	[]ReduceVal,
 	[]StateVal,
+	[]SplitVal,
 	[]Symbol,
 }
 
-symbols: []grammar.SymbolDefinition
-lexemes: []grammar.Symbol
-follow_sets: map[string]grammar.Lookahead
-
-get_child :: proc(val: Value, s: string) -> (v: Value, ok: bool) {
+// children borrow from val and the context unless owned is set, owned
+// values are slices built for the access and freed with delete_value_slice
+get_child :: proc(ctx: Context, val: Value, s: string) -> (v: Value, owned: bool, ok: bool) {
 	#partial switch v in val {
 	case LookaheadVal:
 		switch s {
 		case "symbol":
-			return slice.clone(v.symbol), true
+			return v.symbol, false, true
 		case "accept":
-			return v.accept, true
+			return v.accept, false, true
 		case "shift":
-			return slice.clone(v.shift), true
+			return v.shift, false, true
 		case "reduce":
-			return slice.clone(v.reduce), true
+			return v.reduce, false, true
 		}
 	case ReduceVal:
 		switch s {
 		case "lhs":
-			return v.lhs, true
+			return v.lhs, false, true
 		case "rhs":
-			return slice.clone(v.rhs), true
+			return v.rhs, false, true
 		case "code":
-			return v.code, true
+			return v.code, false, true
+		case "index":
+			return v.index, false, true
 		}
 	case StateVal:
 		switch s {
 		case "index":
-			return v.index, true
+			return v.index, false, true
+		case "id":
+			return v.id, false, true
 		case "lookahead":
-			return slice.clone(v.lookahead), true
+			return v.lookahead, false, true
+		case "action":
+			return v.action, false, true
+		case "goto":
+			return v.goto, false, true
+		case "entry":
+			return v.entry, false, true
+		case "conflict":
+			return v.conflict, false, true
+		}
+	case SplitVal:
+		switch s {
+		case "list":
+			return v.list, false, true
+		case "separator":
+			return v.separator, false, true
+		case "code":
+			return v.code, false, true
 		}
 	case Symbol:
 		switch s {
 		case "name":
-			return v.name, true
+			return v.name, false, true
 		case "enum":
-			return v.enum_name, true
+			return v.enum_name, false, true
 		case "type":
-			return v.type, true
+			return v.type, false, true
+		case "index":
+			// position in the symbol global
+			return int(v.index) - 1, false, true
+		case "column":
+			return ctx.column[v.index], false, true
+		case "type_index":
+			// position in the type global, typed symbols only
+			if i := ctx.type_index[v.index]; i >= 0 {
+				return i, false, true
+			}
 		case "lexeme":
-			return int(v.lexeme), true
+			return int(v.lexeme), false, true
 		case "literal":
-			return int(v.literal), true
+			return int(v.literal), false, true
+		case "first":
+			return ctx.first[v.index], false, true
 		case "follow":
-			follow := make([dynamic]Symbol)
-			for lexeme in follow_sets[v.name] {
-				symbol := int(lexemes[int(lexeme)])
-				if symbol != 0 {
-					append(&follow, symbols[symbol])
-				}
-			}
-			return follow[:], true
+			return ctx.follow[v.index], false, true
 		}
 	case []int:
 		// get element count
 		if s[0] == '"' && s[len(s) - 1] == '"' {
 			i := strconv.parse_int(s[1:len(s) - 1], 10) or_return
-			return slice.count(v, i), true
+			return slice.count(v, i), false, true
 		}
 	case []string:
 		// get element count
 		if s[0] == '"' && s[len(s) - 1] == '"' {
-			return slice.count(v, s[1:len(s) - 1]), true
+			return slice.count(v, s[1:len(s) - 1]), false, true
 		}
 	case int:
 		// get equal
 		if s[0] == '"' && s[len(s) - 1] == '"' {
 			i := strconv.parse_int(s[1:len(s) - 1], 10) or_return
-			return int(v == i), true
+			return int(v == i), false, true
 		}
 	case string:
 		// get equal
 		if s[0] == '"' && s[len(s) - 1] == '"' {
-			return int(v == s[1:len(s) - 1]), true
+			return int(v == s[1:len(s) - 1]), false, true
 		}
 	}
 
 	#partial switch v in val {
-	case []string, []int, []LookaheadVal, []ReduceVal, []StateVal, []Symbol, []void:
+	case []string, []int, []LookaheadVal, []ReduceVal, []StateVal, []SplitVal, []Symbol, []void:
 		it, _ := as_slice(val, false)
 		switch s {
 		case "length":
-			return it.len, true
+			return it.len, false, true
 		case "reversed":
-			reversed := make([]Value, it.len)
-			defer delete(reversed)
-			for elem, idx in iterate_values(&it) {
-				reversed[it.len - idx - 1] = elem
-			}
-			return slice_to_value(reversed), true
+			// only copied when something follows, loops ending in reversed
+			// iterate backwards in place
+			return reverse_slice(val), true, true
 		case:
 			// get slice index
 			if i, ok := strconv.parse_int(s, 10); ok {
 				if i >= 0 && i < it.len do for elem, idx in iterate_values(&it) {
-					if i == idx do return elem, true
+					if i == idx do return elem, false, true
 				}
-				return []void{}, true
+				return []void{}, false, true
 			}
 
 			// get children of elements
 			children := make([dynamic]Value)
 			defer delete(children)
 			for elem in iterate_values(&it) {
-				child := get_child(elem, s) or_return
+				child, child_owned := get_child(ctx, elem, s) or_return
 				if it2, ok := as_slice(child, false); ok {
-					defer delete_value_slice(child)
+					defer if child_owned do delete_value_slice(child)
 					for elem2 in iterate_values(&it2) {
 						append(&children, elem2)
 					}
@@ -160,10 +202,10 @@ get_child :: proc(val: Value, s: string) -> (v: Value, ok: bool) {
 					append(&children, child)
 				}
 			}
-			return slice_to_value(children[:]), true
+			return slice_to_value(children[:]), true, true
 		}
 	}
-	return {}, false
+	return {}, false, false
 }
 
 delete_value :: proc(val: Value) {
@@ -176,6 +218,10 @@ delete_value :: proc(val: Value) {
 		delete(v.rhs)
 	case StateVal:
 		delete_value(v.lookahead)
+		delete(v.action)
+		delete(v.goto)
+		delete(v.entry)
+		delete_value(v.conflict)
 	case:
 		if it, ok := as_slice(val, false); ok {
 			for v in iterate_values(&it) {
@@ -194,6 +240,8 @@ delete_value_slice :: proc(val: Value) {
 		delete(v)
 	case []StateVal:
 		delete(v)
+	case []SplitVal:
+		delete(v)
 	case []Symbol:
 		delete(v)
 	case []int:
@@ -203,6 +251,32 @@ delete_value_slice :: proc(val: Value) {
 	}
 }
 
+reverse_slice :: proc(val: Value) -> Value {
+	reverse :: proc(s: $T/[]$E) -> T {
+		r := slice.clone(s)
+		slice.reverse(r)
+		return r
+	}
+
+	#partial switch v in val {
+	case []int:
+		return reverse(v)
+	case []string:
+		return reverse(v)
+	case []LookaheadVal:
+		return reverse(v)
+	case []ReduceVal:
+		return reverse(v)
+	case []StateVal:
+		return reverse(v)
+	case []SplitVal:
+		return reverse(v)
+	case []Symbol:
+		return reverse(v)
+	}
+	return val
+}
+
 cast_slice :: proc(s: $T/[]$E, $A: typeid) -> []A {
 	slice := make([]A, len(s))
 	for e, i in s {
@@ -227,6 +301,8 @@ slice_to_value :: proc(s: []Value) -> Value {
 		return cast_slice(s, ReduceVal)
 	case StateVal:
 		return cast_slice(s, StateVal)
+	case SplitVal:
+		return cast_slice(s, SplitVal)
 	case Symbol:
 		return cast_slice(s, Symbol)
 	}
@@ -235,35 +311,38 @@ slice_to_value :: proc(s: []Value) -> Value {
 }
 
 ValueIterator :: struct {
-	len:  int,
-	indx: int,
-	data: Value,
+	len:      int,
+	indx:     int,
+	data:     Value,
+	reversed: bool, // slices are walked from the end, indx still counts up
 }
 
 iterate_values :: proc(val: ^ValueIterator) -> (Value, int, bool) {
 
-	iterate :: proc(s: $T/[]$E, indx: ^int) -> (E, int, bool) {
+	iterate :: proc(s: $T/[]$E, indx: ^int, reversed: bool) -> (E, int, bool) {
 		if indx^ >= len(s) do return {}, {}, false
-		e := s[indx^]
+		e := s[len(s) - 1 - indx^] if reversed else s[indx^]
 		indx^ += 1
 		return e, indx^ - 1, true
 	}
 
 	#partial switch v in val.data {
 	case []void:
-		return iterate(v, &val.indx)
+		return iterate(v, &val.indx, val.reversed)
 	case []int:
-		return iterate(v, &val.indx)
+		return iterate(v, &val.indx, val.reversed)
 	case []string:
-		return iterate(v, &val.indx)
+		return iterate(v, &val.indx, val.reversed)
 	case []LookaheadVal:
-		return iterate(v, &val.indx)
+		return iterate(v, &val.indx, val.reversed)
 	case []ReduceVal:
-		return iterate(v, &val.indx)
+		return iterate(v, &val.indx, val.reversed)
 	case []StateVal:
-		return iterate(v, &val.indx)
+		return iterate(v, &val.indx, val.reversed)
+	case []SplitVal:
+		return iterate(v, &val.indx, val.reversed)
 	case []Symbol:
-		return iterate(v, &val.indx)
+		return iterate(v, &val.indx, val.reversed)
 	case int:
 		if val.indx > 0 || v == 0 do return {}, {}, false
 		val.indx += 1
@@ -281,19 +360,41 @@ iterate_values :: proc(val: ^ValueIterator) -> (Value, int, bool) {
 
 as_slice :: proc(val: Value, force: bool) -> (ValueIterator, bool) {
 	#partial switch v in val {
-	case []void, []int, []string, []LookaheadVal, []ReduceVal, []StateVal, []Symbol:
+	case []void, []int, []string, []LookaheadVal, []ReduceVal, []StateVal, []SplitVal, []Symbol:
 		p := val
-		return {len((^[]void)(&p)^), 0, v}, true
+		return {len = len((^[]void)(&p)^), data = v}, true
 	case:
-		return {1, 0, val}, force
+		return {len = 1, data = val}, force
 	}
 }
 
+// numbers printed per line by a list
+INTS_PER_LINE :: 16
+
 print_value :: proc(sb: ^strings.Builder, val: Value) -> bool {
 	#partial switch v in val {
 	case int, string:
 		fmt.sbprint(sb, v)
 		return true
+	case []int:
+		// comma separated, continued lines are indented like the current one
+		line := strings.last_index_byte(string(sb.buf[:]), '\n') + 1
+		indent := line
+		for indent < len(sb.buf) && (sb.buf[indent] == ' ' || sb.buf[indent] == '\t') {
+			indent += 1
+		}
+		prefix := strings.clone(string(sb.buf[line:indent]), context.temp_allocator)
+
+		for n, i in v {
+			if i > 0 && i % INTS_PER_LINE == 0 {
+				strings.write_string(sb, ",\n")
+				strings.write_string(sb, prefix)
+			} else if i > 0 {
+				strings.write_string(sb, ", ")
+			}
+			strings.write_int(sb, n)
+		}
+		return true
 	case ReduceVal:
 		fmt.sbprintf(sb, "%s -> ", v.lhs.name)
 		for token in v.rhs {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -11,6 +12,8 @@ struct array_s {
   unsigned _capacity;
 };
 
+/* length is a hint of how many elements the array will hold, a zeroed
+   array is empty and allocates on its first push */
 #define array_make(type, length) ((struct array_s){(char*)malloc(sizeof(type) * length), 0, length})
 
 static void array_destroy(struct array_s array) {
@@ -20,11 +23,7 @@ static void array_destroy(struct array_s array) {
 }
 
 static void _array_resize(struct array_s *array, size_t size, unsigned length) {
-  char *newdata = (char*)malloc(size * length);
-  memcpy(newdata, array->data, size * length);
-
-  free(array->data);
-  array->data = newdata;
+  array->data = (char*)realloc(array->data, size * length);
   array->_capacity = length;
 }
 
@@ -32,10 +31,104 @@ static void _array_resize(struct array_s *array, size_t size, unsigned length) {
 
 static void _array_push(struct array_s *array, size_t size, void *data) {
   if (array->length == array->_capacity) {
-    _array_resize(array, size, array->_capacity * 2);
+    _array_resize(array, size, array->_capacity ? array->_capacity * 2 : 4);
   }
   memcpy(array->data + array->length * size, data, size);
   array->length++;
 }
 
+/* pushes every element of other, which is left as it is */
+#define array_append(array, other, type) _array_append(&array, sizeof(type), other)
+
+static void _array_append(struct array_s *array, size_t size, struct array_s other) {
+  if (array->length + other.length > array->_capacity) {
+    unsigned capacity = array->_capacity * 2;
+    _array_resize(array, size, capacity > array->length + other.length ? capacity : array->length + other.length);
+  }
+  if (other.length) memcpy(array->data + array->length * size, other.data, size * other.length);
+  array->length += other.length;
+}
+
+/* gives back the capacity beyond the length once the array is complete,
+   realloc may move the elements so the data pointer can change */
+#define array_finalize(array, type) _array_finalize(&array, sizeof(type))
+
+static void _array_finalize(struct array_s *array, size_t size) {
+  if (array->length == array->_capacity) return;
+  if (array->length == 0) {
+    free(array->data);
+    *array = (struct array_s){0};
+    return;
+  }
+  _array_resize(array, size, array->length);
+}
+
 #define array_elem(array, type, index) (((type*)(array.data))[index])
+
+/* arrays can instead be allocated from an arena, which frees all of them
+   at once. The array allocated last grows in place, others move to the top
+   of the arena and leave their old storage unused until it is destroyed.
+   Arena arrays are pushed with array_arena_push and are never passed to
+   array_destroy or array_finalize. Pushing gives false and leaves the
+   array as it was when the arena is out of memory */
+#define ARRAY_ARENA_BLOCK (64 * 1024)
+
+struct array_block_s {
+  struct array_block_s *next;
+};
+
+struct array_arena_s {
+  struct array_block_s *blocks;
+  char                 *top;
+  char                 *end;
+};
+
+static void array_arena_destroy(struct array_arena_s *arena) {
+  while (arena->blocks) {
+    struct array_block_s *next = arena->blocks->next;
+    free(arena->blocks);
+    arena->blocks = next;
+  }
+  arena->top = NULL;
+  arena->end = NULL;
+}
+
+/* bytes aligned for any element, NULL when out of memory */
+static char *_array_arena_alloc(struct array_arena_s *arena, size_t bytes) {
+  bytes = (bytes + 15) & ~(size_t)15;
+  if ((size_t)(arena->end - arena->top) < bytes) {
+    size_t capacity = bytes > ARRAY_ARENA_BLOCK ? bytes : ARRAY_ARENA_BLOCK;
+    struct array_block_s *block = (struct array_block_s*)malloc(16 + capacity);
+    if (block == NULL) return NULL;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->top = (char*)block + 16;
+    arena->end = arena->top + capacity;
+  }
+  char *data = arena->top;
+  arena->top += bytes;
+  return data;
+}
+
+#define array_arena_push(arena, array, elem) _array_arena_push(arena, &array, sizeof(elem), &elem)
+
+static bool _array_arena_push(struct array_arena_s *arena, struct array_s *array, size_t size, void *data) {
+  if (array->length == array->_capacity) {
+    unsigned capacity = array->_capacity ? array->_capacity * 2 : 4;
+    size_t used = (size * array->_capacity + 15) & ~(size_t)15;
+    size_t grown = (size * capacity + 15) & ~(size_t)15;
+
+    if (array->data && array->data + used == arena->top && (size_t)(arena->end - array->data) >= grown) {
+      arena->top = array->data + grown;
+    } else {
+      char *newdata = _array_arena_alloc(arena, size * capacity);
+      if (newdata == NULL) return false;
+      if (array->length) memcpy(newdata, array->data, size * array->length);
+      array->data = newdata;
+    }
+    array->_capacity = capacity;
+  }
+  memcpy(array->data + array->length * size, data, size);
+  array->length++;
+  return true;
+}
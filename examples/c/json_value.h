@@ -0,0 +1,80 @@
+#pragma once
+
+/* the values the JSON grammars build, shared by the preambles of
+   examples/json_c.txt and examples/json_lines_c.txt */
+#include <stdbool.h>
+
+#include "array.h"
+
+/* objects are Swiss tables whose members are appended as they are parsed
+   and indexed once the object is complete, sized for its member count.
+   Define JSON_HASHMAP for the previous crc32 hashmap, which bench/runtime.sh
+   can be pointed at to compare the two */
+#ifdef JSON_HASHMAP
+#include "hashmap.h"
+typedef struct hashmap_s json_object;
+typedef struct hashmap_element_s json_member;
+#define json_object_append(object, key, length, value) \
+  ((object)->data == NULL ? (void)hashmap_create(16, object) : (void)0, (void)hashmap_put(object, key, length, value))
+#define json_object_index(object) ((void)0)
+#define json_object_iterate       hashmap_iterate
+#define json_object_iterate_pairs hashmap_iterate_pairs
+#define json_object_destroy       hashmap_destroy
+#else
+#include "swisstable.h"
+typedef struct swiss_s json_object;
+typedef struct swiss_element_s json_member;
+#define json_object_append        swiss_append
+#define json_object_index         swiss_index
+#define json_object_iterate       swiss_iterate
+#define json_object_iterate_pairs swiss_iterate_pairs
+#define json_object_destroy       swiss_destroy
+#endif
+
+typedef struct {
+  const char *string;
+  unsigned length;
+} json_string;
+
+typedef struct array_s json_array;
+
+/* arrays own their storage, or with JSON_ARENA are pushed into the
+   struct array_arena_s the parse is given as its PARCELR_CONTEXT, which
+   frees all of them at once. bench/runtime.sh can be pointed at either */
+#ifdef JSON_ARENA
+#define json_array_make(length)      ((json_array){0})
+#define json_array_push(array, elem) array_arena_push(context, array, elem)
+#define json_array_finalize(array)   ((void)0)
+#define json_array_destroy(array)    ((void)0)
+#else
+#define json_array_make(length)      array_make(json_value, length)
+#define json_array_push(array, elem) array_push(array, elem)
+#define json_array_finalize(array)   array_finalize(array, json_value)
+#define json_array_destroy(array)    array_destroy(array)
+#endif
+
+typedef enum {
+  JSON_NULL, JSON_OBJECT, JSON_ARRAY, JSON_STRING, JSON_NUMBER, JSON_BOOL
+} json_type;
+
+typedef struct {
+  json_type type;
+  union {
+    json_object object;
+    json_array array;
+    json_string string;
+    double number;
+    bool boolean;
+  } data;
+} json_value;
+
+typedef struct {
+  json_string key;
+  json_value value;
+} json_entry;
+
+static json_value *alloc_clone(json_value value) {
+  json_value *dup = (json_value*)malloc(sizeof(json_value));
+  memcpy(dup, &value, sizeof(json_value));
+  return dup;
+}
@@ -10,7 +10,7 @@ struct stack_s {
   unsigned _capacity;
 };
 
-#define stack_make(length) ((struct stack_s){(size_t*)malloc(sizeof(size_t) * length), 0, length})
+#define stack_make(length) ((struct stack_s){(size_t*)malloc(sizeof(size_t) * (length)), 0, (length)})
 
 static void stack_destroy(struct stack_s stack) {
   free(stack.data);
@@ -19,11 +19,7 @@ static void stack_destroy(struct stack_s stack) {
 }
 
 static void _stack_resize(struct stack_s *stack, unsigned length) {
-  size_t* newdata = (size_t*)malloc(sizeof(size_t) * length);
-  memcpy(newdata, stack->data, sizeof(size_t) * length);
-
-  free(stack->data);
-  stack->data = newdata;
+  stack->data = (size_t*)realloc(stack->data, sizeof(size_t) * length);
   stack->_capacity = length;
 }
 
@@ -38,7 +34,8 @@ static void _stack_push(struct stack_s *stack, size_t size, void *data) {
     _stack_resize(stack, newcap);
   }
 
-  memcpy(&stack->data[stack->length], data, length * sizeof(size_t));
+  /* only size bytes, elem may be smaller than the words it takes up */
+  memcpy(&stack->data[stack->length], data, size);
   stack->length += length;
 }
 
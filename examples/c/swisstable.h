@@ -0,0 +1,272 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+  #include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+  #include <intrin.h>
+#endif
+
+/* a map from byte strings to pointers in the style of Swiss tables: every
+   bucket has a control byte holding 7 bits of the hash of its key, and
+   lookups compare the control bytes of a group of 16 buckets at once with
+   SSE2. The members themselves are kept in insertion order in one array,
+   the buckets only index them, so growing never moves a member and
+   iterating visits no empty buckets.
+
+   Keys are not copied and have to outlive the map. Members are never
+   removed, a put on an existing key replaces its data.
+
+   Maps can be filled in two ways, swiss_put keeps them indexed after
+   every call while swiss_append only stores the member and swiss_index
+   builds the index once for all of them, sized for their count. Lookups
+   need an index and do not see members appended after it was built */
+
+#define SWISS_GROUP 16
+#define SWISS_EMPTY 0x80
+
+struct swiss_element_s {
+  const char *key;
+  unsigned    key_len;
+  uint32_t    hash;
+  void       *data;
+};
+
+/* followed by the control bytes and then the element index of each bucket */
+struct swiss_header_s {
+  unsigned length;
+  unsigned capacity;
+  unsigned indexed;  /* elements in the index */
+  unsigned groups;   /* a power of two, 0 without an index */
+};
+
+/* two pointers, so maps are cheap to hold by value, all of the bookkeeping
+   lives behind _header and a zeroed map is empty */
+struct swiss_s {
+  struct swiss_element_s *elements;
+  struct swiss_header_s  *_header;
+};
+
+#define swiss_control(header) ((uint8_t*)((header) + 1))
+#define swiss_slots(header)   ((uint32_t*)(swiss_control(header) + (size_t)(header)->groups * SWISS_GROUP))
+
+/* hashes a word at a time, the tail in one partial word */
+static inline uint32_t swiss_hash(const char *key, unsigned len) {
+  uint64_t h = 0x9e3779b97f4a7c15ull ^ len;
+  uint64_t word;
+
+  for (; len >= 8; key += 8, len -= 8) {
+    memcpy(&word, key, 8);
+    h = (h ^ word) * 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 31;
+  }
+  if (len > 0) {
+    word = 0;
+    memcpy(&word, key, len);
+    h = (h ^ word) * 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 31;
+  }
+
+  h = (h ^ (h >> 32)) * 0x94d049bb133111ebull;
+  return (uint32_t)(h ^ (h >> 29));
+}
+
+/* bit i is set when control byte i of the group equals byte */
+static inline unsigned swiss_match(const uint8_t *group, uint8_t byte) {
+#ifdef __SSE2__
+  __m128i control = _mm_loadu_si128((const __m128i*)group);
+  return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)byte)));
+#else
+  unsigned mask = 0;
+  for (unsigned i = 0; i < SWISS_GROUP; i++) {
+    mask |= (unsigned)(group[i] == byte) << i;
+  }
+  return mask;
+#endif
+}
+
+static inline unsigned swiss_first(unsigned mask) {
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanForward(&i, mask);
+  return (unsigned)i;
+#else
+  return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+/* the bucket holding the key, or else the empty bucket it would go in,
+   groups are probed in triangular steps which visit every one of them */
+static inline int swiss_find(const struct swiss_s *m, const char *key, unsigned len, uint32_t hash,
+                             unsigned *bucket) {
+  const struct swiss_header_s *h = m->_header;
+  const uint8_t *control = swiss_control(h);
+  const uint32_t *slots = swiss_slots(h);
+  unsigned group = (hash >> 7) & (h->groups - 1);
+  uint8_t tag = hash & 0x7f;
+
+  for (unsigned step = 1;; step++) {
+    const uint8_t *g = control + group * SWISS_GROUP;
+
+    for (unsigned match = swiss_match(g, tag); match; match &= match - 1) {
+      unsigned b = group * SWISS_GROUP + swiss_first(match);
+      const struct swiss_element_s *e = &m->elements[slots[b]];
+      if (e->hash == hash && e->key_len == len && memcmp(e->key, key, len) == 0) {
+        *bucket = b;
+        return 1;
+      }
+    }
+
+    unsigned empty = swiss_match(g, SWISS_EMPTY);
+    if (empty) {
+      *bucket = group * SWISS_GROUP + swiss_first(empty);
+      return 0;
+    }
+    group = (group + step) & (h->groups - 1);
+  }
+}
+
+/* a header with no members and an unfilled index of groups groups */
+static inline void swiss_resize_header(struct swiss_s *m, unsigned groups) {
+  size_t buckets = (size_t)groups * SWISS_GROUP;
+  struct swiss_header_s *h = (struct swiss_header_s*)realloc(m->_header,
+    sizeof(struct swiss_header_s) + buckets + buckets * sizeof(uint32_t));
+  if (m->_header == NULL) *h = (struct swiss_header_s){ 0, 0, 0, 0 };
+  h->groups = groups;
+  m->_header = h;
+}
+
+/* an index of the smallest size keeping count elements at most 7/8 full */
+static inline void swiss_reset_index(struct swiss_s *m, unsigned count) {
+  unsigned groups = 1;
+  while (groups * SWISS_GROUP * 7 / 8 < count) groups *= 2;
+
+  if (m->_header == NULL || groups != m->_header->groups) swiss_resize_header(m, groups);
+  memset(swiss_control(m->_header), SWISS_EMPTY, (size_t)groups * SWISS_GROUP);
+  m->_header->indexed = 0;
+}
+
+static inline void swiss_reserve(struct swiss_s *m, unsigned count) {
+  if (m->_header == NULL) swiss_resize_header(m, 0);
+  if (count <= m->_header->capacity) return;
+  m->elements = (struct swiss_element_s*)realloc(m->elements, sizeof(struct swiss_element_s) * count);
+  m->_header->capacity = count;
+}
+
+static inline void swiss_grow(struct swiss_s *m) {
+  unsigned capacity = m->_header ? m->_header->capacity : 0;
+  if (m->_header == NULL || m->_header->length == capacity) swiss_reserve(m, capacity ? capacity * 2 : 4);
+}
+
+/* capacity is a hint of how many members the map will hold */
+static inline int swiss_create(unsigned capacity, struct swiss_s *out) {
+  memset(out, 0, sizeof(struct swiss_s));
+  if (capacity > 0) {
+    swiss_reserve(out, capacity);
+    swiss_reset_index(out, capacity);
+  }
+  return 0;
+}
+
+static inline void swiss_destroy(struct swiss_s *m) {
+  free(m->elements);
+  free(m->_header);
+  memset(m, 0, sizeof(struct swiss_s));
+}
+
+/* adds a member without looking for its key, see swiss_index */
+static inline void swiss_append(struct swiss_s *m, const char *key, unsigned len, void *value) {
+  swiss_grow(m);
+  m->elements[m->_header->length++] = (struct swiss_element_s){ key, len, swiss_hash(key, len), value };
+}
+
+/* indexes every element in an index sized for count of them, later
+   elements replace the data of earlier ones with the same key and are
+   dropped */
+static inline void swiss_rebuild(struct swiss_s *m, unsigned count) {
+  swiss_reset_index(m, count);
+  struct swiss_header_s *h = m->_header;
+  uint8_t *control = swiss_control(h);
+  uint32_t *slots = swiss_slots(h);
+
+  unsigned kept = 0;
+  for (unsigned i = 0; i < h->length; i++) {
+    struct swiss_element_s e = m->elements[i];
+    unsigned bucket;
+    if (swiss_find(m, e.key, e.key_len, e.hash, &bucket)) {
+      m->elements[slots[bucket]].data = e.data;
+      continue;
+    }
+    m->elements[kept] = e;
+    control[bucket] = e.hash & 0x7f;
+    slots[bucket] = kept++;
+  }
+  h->length = kept;
+  h->indexed = kept;
+}
+
+/* indexes the appended members, sized for how many there are */
+static inline void swiss_index(struct swiss_s *m) {
+  if (m->_header && m->_header->length > 0) swiss_rebuild(m, m->_header->length);
+}
+
+static inline int swiss_put(struct swiss_s *m, const char *key, unsigned len, void *value) {
+  struct swiss_header_s *h = m->_header;
+  if (h == NULL || h->indexed != h->length || h->length + 1 > h->groups * SWISS_GROUP * 7 / 8) {
+    unsigned length = h ? h->length : 0;
+    swiss_rebuild(m, length * 2 > length + 1 ? length * 2 : length + 1);
+  }
+
+  uint32_t hash = swiss_hash(key, len);
+  unsigned bucket;
+  if (swiss_find(m, key, len, hash, &bucket)) {
+    m->elements[swiss_slots(m->_header)[bucket]].data = value;
+    return 0;
+  }
+
+  swiss_grow(m);
+  h = m->_header;
+  m->elements[h->length] = (struct swiss_element_s){ key, len, hash, value };
+  swiss_control(h)[bucket] = hash & 0x7f;
+  swiss_slots(h)[bucket] = h->length++;
+  h->indexed = h->length;
+  return 0;
+}
+
+/* NULL when the key is not in the index */
+static inline void *swiss_get(const struct swiss_s *m, const char *key, unsigned len) {
+  if (m->_header == NULL || m->_header->groups == 0) return NULL;
+  unsigned bucket;
+  if (!swiss_find(m, key, len, swiss_hash(key, len), &bucket)) return NULL;
+  return m->elements[swiss_slots(m->_header)[bucket]].data;
+}
+
+static inline unsigned swiss_num_entries(const struct swiss_s *m) {
+  return m->_header ? m->_header->length : 0;
+}
+
+/* calls f on the data of every member in insertion order while it returns
+   nonzero, returns 1 when it stopped early */
+static inline int swiss_iterate(const struct swiss_s *m, int (*f)(void *const, void *const),
+                                void *const context) {
+  unsigned length = swiss_num_entries(m);
+  for (unsigned i = 0; i < length; i++) {
+    if (!f(context, m->elements[i].data)) return 1;
+  }
+  return 0;
+}
+
+/* calls f on every member in insertion order while it returns 0, returns
+   1 when it stopped early */
+static inline int swiss_iterate_pairs(struct swiss_s *m, int (*f)(void *const, struct swiss_element_s *const),
+                                      void *const context) {
+  unsigned length = swiss_num_entries(m);
+  for (unsigned i = 0; i < length; i++) {
+    if (f(context, &m->elements[i])) return 1;
+  }
+  return 0;
+}
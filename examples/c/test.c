@@ -9,7 +9,7 @@ typedef struct {
   bool first;
 } ctx;
 
-int print_elem(void* const context, struct hashmap_element_s* const e) {
+int print_elem(void* const context, json_member* const e) {
   int indent = ((ctx*)context)->indent;
   bool first = ((ctx*)context)->first;
   if (first) ((ctx*)context)->first = false;
@@ -62,7 +62,7 @@ void print(json_value value, int indent) {
     case JSON_OBJECT:
     {
       ctx context = { indent, true };
-      hashmap_iterate_pairs(&value.data.object, print_elem, &context);
+      json_object_iterate_pairs(&value.data.object, print_elem, &context);
       break;
     }
   }
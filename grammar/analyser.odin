@@ -23,6 +23,14 @@ Table :: []map[Symbol]Decision
 Reduce :: distinct Rule // number refers to rule
 Shift :: distinct int // number refers to state
 
+// decisions left out of the table when a cell has more than one, used by
+// GLR parsers: the table keeps the shift or the first reduce
+Cell :: struct {
+	state:  int,
+	symbol: Symbol,
+}
+Conflicts :: map[Cell][dynamic]Decision
+
 Analyser :: enum {
 	LR0,
 	SLR1,
@@ -30,6 +38,16 @@ Analyser :: enum {
 	LALR1,
 }
 
+// work done by the analyser, the caller may reset these between runs
+Counters :: struct {
+	states:      int, // states created by calc_table
+	closures:    int, // calls to predict
+	items:       int, // items taken off the prediction stack
+	lalr_merges: int, // states merged into an existing LALR(1) state
+}
+
+counters: Counters
+
 predict :: proc(
 	g: Grammar,
 	type: Analyser,
@@ -38,6 +56,8 @@ predict :: proc(
 	first: []Lookahead,
 	follow: []Lookahead,
 ) -> []Item {
+	counters.closures += 1
+
 	stack := slice.clone_to_dynamic(set)
 	prediction := slice.clone_to_dynamic(set)
 
@@ -45,6 +65,7 @@ predict :: proc(
 
 	for len(stack) > 0 {
 		item := pop(&stack)
+		counters.items += 1
 
 		rhs := g.rules[item.rule].rhs
 		if len(rhs) <= item.index do continue
@@ -168,12 +189,69 @@ delete_table :: proc(t: Table) {
 	delete(t)
 }
 
+Settlement :: enum {
+	None,
+	Shift,
+	Reduce,
+	Error,
+}
+
+// settles a shift/reduce conflict with the declared precedences: a rule
+// takes the precedence of its %prec lexeme or else of its last lexeme,
+// the higher one wins and a tie goes by the associativity of the lexeme
+settle :: proc(g: Grammar, rule: Rule, lexeme: Symbol) -> Settlement {
+	r := g.rules[rule]
+	prec := r.prec
+	if prec == ROOT {
+		for k := len(r.rhs) - 1; k >= 0; k -= 1 {
+			if g.symbols[r.rhs[k]].lexeme {
+				prec = r.rhs[k]
+				break
+			}
+		}
+	}
+
+	left, right := g.symbols[prec].precedence, g.symbols[lexeme].precedence
+	switch {
+	case left == 0 || right == 0:
+		return .None
+	case left > right:
+		return .Reduce
+	case left < right:
+		return .Shift
+	}
+
+	switch g.symbols[lexeme].associativity {
+	case .Left:
+		return .Reduce
+	case .Right:
+		return .Shift
+	case .Nonassoc:
+		return .Error
+	}
+	return .None
+}
+
+delete_conflicts :: proc(c: Conflicts) {
+	for _, decisions in c {
+		delete(decisions)
+	}
+	delete(c)
+}
+
+add_conflict :: proc(c: ^Conflicts, cell: Cell, d: Decision) {
+	_, decisions, _, _ := map_entry(c, cell)
+	if !slice.contains(decisions[:], d) do append(decisions, d)
+}
+
+// conflicts are an error unless a map is given to collect them in
 calc_table :: proc(
 	g: Grammar,
 	type: Analyser,
 	empty: map[Symbol]void,
 	first: []Lookahead,
 	follow: []Lookahead,
+	conflicts: ^Conflicts = nil,
 ) -> (
 	Table,
 	Error,
@@ -196,6 +274,7 @@ calc_table :: proc(
 	start := predict(g, type, {{Rule(0), 0, {EOF}}}, empty, first, follow)
 	append(&stack, StackEntry{start, 0})
 	append(&table, make(map[Symbol]Decision))
+	counters.states += 1
 
 	// the following are used for LALR(1) parsing
 	final_sets := make([dynamic][]Item)
@@ -221,72 +300,101 @@ calc_table :: proc(
 		part := partition(g, pset)
 		defer delete(part)
 
-		for sym, items in part {
-			if sym == ROOT {
-				defer delete(items)
-				for item in items {
-					e := Reduce(item.rule)
-					for lex in LEX_MIN ..= LEX_MAX {
-						if !(lex in item.lookahead) do continue
-						next := g.lexemes[lex]
-						if next in table[i] && table[i][next] != e {
-							// TODO better errors
-							switch _ in table[i][next] {
-							case Shift:
-								delete_table(table[:])
-								return {}, "SHIFT/REDUCE CONFLICT"
-							case Reduce:
-								delete_table(table[:])
-								return {}, "REDUCE/REDUCE CONFLICT"
-							}
+		// reductions go in first so shifts can be settled against them
+		if items, ok := part[ROOT]; ok {
+			defer delete(items)
+			for item in items {
+				e := Reduce(item.rule)
+				for lex in LEX_MIN ..= LEX_MAX {
+					if !(lex in item.lookahead) do continue
+					next := g.lexemes[lex]
+					if next in table[i] && table[i][next] != e {
+						if _, ok := table[i][next].(Shift); ok && settle(g, item.rule, next) != .None {
+							// settled again when the shift is added below
+							table[i][next] = e
+							continue
+						}
+						if conflicts != nil {
+							add_conflict(conflicts, {i, next}, e)
+							continue
+						}
+						// TODO better errors
+						switch _ in table[i][next] {
+						case Shift:
+							delete_table(table[:])
+							return {}, "SHIFT/REDUCE CONFLICT"
+						case Reduce:
+							delete_table(table[:])
+							return {}, "REDUCE/REDUCE CONFLICT"
 						}
-						table[i][next] = e
 					}
+					table[i][next] = e
 				}
-			} else {
-				if sym in table[i] {
-					// TODO better errors
-					switch _ in table[i][sym] {
-					case Shift:
-					// we assume we are merging two identical shifts
-					case Reduce:
+			}
+		}
+
+		for sym, items in part {
+			if sym == ROOT do continue
+
+			if sym in table[i] {
+				// TODO better errors
+				switch v in table[i][sym] {
+				case Shift:
+				// we assume we are merging two identical shifts
+				case Reduce:
+					switch settle(g, Rule(v), sym) {
+					case .Shift:
+					case .Reduce:
+						delete(items)
+						continue
+					case .Error:
+						delete_key(&table[i], sym)
+						delete(items)
+						continue
+					case .None:
+						if conflicts != nil {
+							add_conflict(conflicts, {i, sym}, v)
+							break
+						}
 						delete_table(table[:])
 						return {}, "SHIFT/REDUCE CONFLICT"
 					}
 				}
+			}
 
-				if idx, ok := find_entry(stack[:], items); ok {
-					// we found an identical state
-					table[i][sym] = Shift(idx)
-					delete(items)
-				} else {
-					idx: int
-					ok := false
-					if type == .LALR1 {
-						// check if states can be merged
-						clone := slice.clone(items)
-						for &item in clone do item.lookahead = {}
-
-						idx, ok = indexof_slice(final_sets[:], clone)
-
-						if ok {
-							delete(clone)
-						} else {
-							append(&final_sets, clone)
-						}
-					}
+			if idx, ok := find_entry(stack[:], items); ok {
+				// we found an identical state
+				table[i][sym] = Shift(idx)
+				delete(items)
+			} else {
+				idx: int
+				ok := false
+				if type == .LALR1 {
+					// check if states can be merged
+					clone := slice.clone(items)
+					for &item in clone do item.lookahead = {}
+
+					idx, ok = indexof_slice(final_sets[:], clone)
 
 					if ok {
-						// mark entry to be merged with a previous state
-						table[i][sym] = Shift(idx)
-						append(&stack, StackEntry{items, idx})
+						delete(clone)
 					} else {
-						// create a new state
-						table[i][sym] = Shift(len(table))
-						append(&stack, StackEntry{items, len(table)})
-						append(&table, make(map[Symbol]Decision))
+						append(&final_sets, clone)
 					}
 				}
+
+				if ok {
+					// mark entry to be merged with a previous state
+					table[i][sym] = Shift(idx)
+					counters.lalr_merges += 1
+					append(&stack, StackEntry{items, idx})
+				} else {
+					// create a new state
+					table[i][sym] = Shift(len(table))
+					append(&stack, StackEntry{items, len(table)})
+					append(&table, make(map[Symbol]Decision))
+					counters.states += 1
+				}
 			}
 		}
 	}
@@ -1,7 +1,7 @@
 package grammar
 
 import "core:encoding/csv"
-import "core:fmt"
+import "core:slice"
 import "core:strings"
 
 Symbol :: distinct int
@@ -14,14 +14,33 @@ RuleDefinition :: struct {
 	lhs:  Symbol,
 	rhs:  []Symbol,
 	code: string,
+	prec: Symbol, // given with %prec, ROOT to use the last lexeme with a precedence
+}
+
+Associativity :: enum {
+	Left,
+	Right,
+	Nonassoc,
 }
 
 SymbolDefinition :: struct {
-	name:      string,
-	enum_name: string,
-	type:      string,
-	lexeme:    bool,
-	literal:   bool,
+	name:          string,
+	enum_name:     string,
+	type:          string,
+	lexeme:        bool,
+	literal:       bool,
+	precedence:    int, // later %left, %right and %nonassoc lines bind tighter, 0 without
+	associativity: Associativity,
+}
+
+// %split list separator // code // ; lets a parser split its input at every
+// separator and parse the pieces apart, each of them is a list of its own.
+// The code merges the value of the next piece, _1, into that of the pieces
+// before it, _0, like a rule list -> list list would
+Split :: struct {
+	list:      Symbol, // ROOT without %split
+	separator: Symbol,
+	code:      string,
 }
 
 Grammar :: struct {
@@ -29,6 +48,7 @@ Grammar :: struct {
 	symbols:  []SymbolDefinition,
 	lexemes:  []Symbol,
 	preamble: string,
+	split:    Split,
 }
 
 ROOT :: Symbol(0)
@@ -54,8 +74,8 @@ delete_grammar :: proc(g: Grammar) {
 	for rule in g.rules {
 		delete(rule.rhs)
 	}
+	// names point into the grammar file
 	for symbol in g.symbols[3:] {
-		delete(symbol.name)
 		delete(symbol.enum_name)
 	}
 	delete(g.rules)
@@ -63,53 +83,60 @@ delete_grammar :: proc(g: Grammar) {
 	delete(g.lexemes)
 }
 
+// symbol names, code and the preamble are views into d, which has to
+// outlive the grammar
 parse_grammar :: proc(d: []u8) -> (Grammar, Error) {
 	rules := make([dynamic]RuleDefinition)
 	symbols := make([dynamic]SymbolDefinition)
 
 	// append ROOT, EOF, and ERR symbols
 	rhs := make([]Symbol, 1)
-	append(&rules, RuleDefinition{ROOT, rhs, {}})
-	append(&symbols, SymbolDefinition{"ROOT", {}, {}, false, false}) // won't show up in templates but it's nice for debug information
-	append(&symbols, SymbolDefinition{"$", "EOF", {}, true, false})
-	append(&symbols, SymbolDefinition{"error", "ERR", {}, true, false})
+	append(&rules, RuleDefinition{ROOT, rhs, {}, ROOT})
+	append(&symbols, SymbolDefinition{"ROOT", {}, {}, false, false, 0, {}}) // won't show up in templates but it's nice for debug information
+	append(&symbols, SymbolDefinition{"$", "EOF", {}, true, false, 0, {}})
+	append(&symbols, SymbolDefinition{"error", "ERR", {}, true, false, 0, {}})
+
+	names := make(map[string]Symbol)
+	defer delete(names)
+	for def, idx in symbols {
+		names[def.name] = Symbol(idx)
+	}
 
 	EXPR_ASSIGN :: "->"
 	EXPR_DONE :: ";"
 	CODE_OPEN :: "//"
 	CODE_CLOSE :: "//"
+	PREC :: "%prec"
+	SPLIT :: "%split"
+
+	// symbols are interned by name, the names are views into the grammar
+	// file and only the enum name of a new symbol is allocated
+	get_symbol :: proc(
+		symbols: ^[dynamic]SymbolDefinition,
+		names: ^map[string]Symbol,
+		token: string,
+	) -> Symbol {
+		literal := len(token) > 1 && token[0] == '"' && token[len(token) - 1] == '"'
+		name := token[1:len(token) - 1] if literal else token
+		if sym, ok := names[name]; ok {
+			return sym
+		}
 
-	get_symbol :: proc(symbols: ^[dynamic]SymbolDefinition, token: string) -> Symbol {
-		name: string
 		enum_name: string
-		literal := false
-		if token[0] == '"' && token[len(token) - 1] == '"' {
-			literal = true
-			name = strings.clone(token[1:len(token) - 1])
-			if alias, ok := aliases[name]; ok {
-				enum_name = strings.clone(alias)
-			} else if alias, ok := aliases[name[:len(name) - 1]];
-			   ok && name[len(name) - 1] == '=' {
-				sb: strings.Builder
-				fmt.sbprint(&sb, alias)
-				fmt.sbprint(&sb, "_EQUALS")
-				enum_name = strings.to_string(sb)
-			} else {
-				enum_name = strings.to_upper(name)
-			}
+		if !literal {
+			enum_name = strings.clone(name)
+		} else if alias, ok := aliases[name]; ok {
+			enum_name = strings.clone(alias)
+		} else if alias, ok := aliases[name[:len(name) - 1]]; ok && name[len(name) - 1] == '=' {
+			enum_name = strings.concatenate({alias, "_EQUALS"})
 		} else {
-			name = strings.clone(token)
-			enum_name = strings.clone(token)
-		}
-		for sym, idx in symbols {
-			if name == sym.name {
-				delete(name)
-				delete(enum_name)
-				return Symbol(idx)
-			}
+			enum_name = strings.to_upper(name)
 		}
-		append(symbols, SymbolDefinition{name, enum_name, {}, true, literal})
-		return Symbol(len(symbols) - 1)
+
+		sym := Symbol(len(symbols))
+		append(symbols, SymbolDefinition{name, enum_name, {}, true, literal, 0, {}})
+		names[name] = sym
+		return sym
 	}
 
 	parse_token :: proc(data: ^[]u8) -> string {
@@ -173,21 +200,79 @@ parse_grammar :: proc(d: []u8) -> (Grammar, Error) {
 		copy := data
 		token := parse_token(&copy)
 		if token == CODE_OPEN {
-			delete_grammar({rules[:], symbols[:], {}, {}})
+			delete_grammar({rules[:], symbols[:], {}, {}, {}})
 			return {}, "'" + CODE_CLOSE + "' expected"
 		}
 	}
 
+	// the level of the last precedence line
+	level := 0
+	split: Split
+
 	for {
 		token := parse_token(&data)
 
 		if token == "" do break
+
+		// %left "+" "-" ; declares the lexemes of one precedence level
+		declaration := true
+		associativity: Associativity
+		switch token {
+		case "%left":
+			associativity = .Left
+		case "%right":
+			associativity = .Right
+		case "%nonassoc":
+			associativity = .Nonassoc
+		case:
+			declaration = false
+		}
+		if declaration {
+			level += 1
+			for {
+				token := parse_token(&data)
+				if token == EXPR_DONE do break
+				if token == "" || token == EXPR_ASSIGN || token == CODE_OPEN || token == PREC {
+					delete_grammar({rules[:], symbols[:], {}, {}, {}})
+					return {}, "lexeme or '" + EXPR_DONE + "' expected"
+				}
+				symbol := get_symbol(&symbols, &names, token)
+				symbols[symbol].precedence = level
+				symbols[symbol].associativity = associativity
+			}
+			continue
+		}
+
+		// %split lines NEWLINE // code // ; is checked once every rule is known
+		if token == SPLIT {
+			if split.list != ROOT {
+				delete_grammar({rules[:], symbols[:], {}, {}, {}})
+				return {}, "only one '" + SPLIT + "' allowed"
+			}
+			pair: [2]Symbol
+			for i in 0 ..< len(pair) {
+				token := parse_token(&data)
+				if token == "" || token == EXPR_DONE || token == EXPR_ASSIGN || token == CODE_OPEN || token == PREC {
+					delete_grammar({rules[:], symbols[:], {}, {}, {}})
+					return {}, "list and separator expected after '" + SPLIT + "'"
+				}
+				pair[i] = get_symbol(&symbols, &names, token)
+			}
+			split.list, split.separator = pair[0], pair[1]
+			split.code = parse_optional_code(&data)
+			if parse_token(&data) != EXPR_DONE {
+				delete_grammar({rules[:], symbols[:], {}, {}, {}})
+				return {}, "'" + EXPR_DONE + "' expected"
+			}
+			continue
+		}
+
 		if token == EXPR_DONE || token == EXPR_ASSIGN || token == CODE_CLOSE {
-			delete_grammar({rules[:], symbols[:], {}, {}})
+			delete_grammar({rules[:], symbols[:], {}, {}, {}})
 			return {}, "lhs or EOF expected"
 		}
 
-		lhs := get_symbol(&symbols, token)
+		lhs := get_symbol(&symbols, &names, token)
 		symbols[lhs].type = parse_optional_code(&data)
 
 		{
@@ -196,11 +281,11 @@ parse_grammar :: proc(d: []u8) -> (Grammar, Error) {
 				continue
 			}
 			if token == CODE_OPEN {
-				delete_grammar({rules[:], symbols[:], {}, {}})
+				delete_grammar({rules[:], symbols[:], {}, {}, {}})
 				return {}, "'" + CODE_CLOSE + "' expected"
 			}
 			if token != EXPR_ASSIGN {
-				delete_grammar({rules[:], symbols[:], {}, {}})
+				delete_grammar({rules[:], symbols[:], {}, {}, {}})
 				return {}, "'" + EXPR_ASSIGN + "' or '" + EXPR_DONE + "' expected"
 			}
 		}
@@ -212,45 +297,63 @@ parse_grammar :: proc(d: []u8) -> (Grammar, Error) {
 
 		outer: for {
 			rhs := make([dynamic]Symbol)
+			prec := ROOT
 
 			for {
 				code := parse_optional_code(&data)
 				if code != {} {
 					token := parse_token(&data)
 					if token == EXPR_DONE || token == EXPR_ASSIGN {
-						append(&rules, RuleDefinition{lhs, rhs[:], code})
+						append(&rules, RuleDefinition{lhs, rhs[:], code, prec})
 						if token == EXPR_DONE do break outer
 						continue outer
 					}
 
 					delete(rhs)
-					delete_grammar({rules[:], symbols[:], {}, {}})
+					delete_grammar({rules[:], symbols[:], {}, {}, {}})
 					return {}, "'" + EXPR_ASSIGN + "' or '" + EXPR_DONE + "' expected"
 				}
 
 				token := parse_token(&data)
 
 				if token == EXPR_DONE || token == EXPR_ASSIGN {
-					append(&rules, RuleDefinition{lhs, rhs[:], code})
+					append(&rules, RuleDefinition{lhs, rhs[:], code, prec})
 					if token == EXPR_DONE do break outer
 					continue outer
 				}
 				if token == CODE_OPEN {
 					delete(rhs)
-					delete_grammar({rules[:], symbols[:], {}, {}})
+					delete_grammar({rules[:], symbols[:], {}, {}, {}})
 					return {}, "'" + CODE_CLOSE + "' expected"
 				}
 				if token == "" || token == CODE_CLOSE {
 					delete(rhs)
-					delete_grammar({rules[:], symbols[:], {}, {}})
+					delete_grammar({rules[:], symbols[:], {}, {}, {}})
 					return {}, "rhs, '" + EXPR_ASSIGN + "', or '" + EXPR_DONE + "' expected"
 				}
+				if token == PREC {
+					token := parse_token(&data)
+					if token == "" || token == EXPR_DONE || token == EXPR_ASSIGN || token == CODE_OPEN {
+						delete(rhs)
+						delete_grammar({rules[:], symbols[:], {}, {}, {}})
+						return {}, "lexeme expected after '" + PREC + "'"
+					}
+					prec = get_symbol(&symbols, &names, token)
+					continue
+				}
 
-				append(&rhs, get_symbol(&symbols, token))
+				append(&rhs, get_symbol(&symbols, &names, token))
 			}
 		}
 	}
 
+	if split.list != ROOT {
+		if err := check_split(rules[:], symbols[:], split); err != {} {
+			delete_grammar({rules[:], symbols[:], {}, {}, {}})
+			return {}, err
+		}
+	}
+
 	lexemes := make([dynamic]Symbol)
 	for def, idx in symbols {
 		if def.lexeme {
@@ -258,6 +361,54 @@ parse_grammar :: proc(d: []u8) -> (Grammar, Error) {
 		}
 	}
 
-	return {rules[:], symbols[:], lexemes[:], preamble}, {}
+	return {rules[:], symbols[:], lexemes[:], preamble, split}, {}
+}
+
+// the input can only be split at a separator when every separator ends an
+// element of the top level list, and the elements after it are a list on
+// their own. So the list has to be the start symbol, only its own rules may
+// use it or the separator, and those that do have to be list -> list sep a
+// with a rule list -> a for the first element of a piece
+@(private)
+check_split :: proc(rules: []RuleDefinition, symbols: []SymbolDefinition, split: Split) -> Error {
+	list, sep := split.list, split.separator
+	if symbols[list].lexeme || rules[0].rhs[0] != list {
+		return "'%split' list has to be the start symbol"
+	}
+	// symbols 1 and 2 are EOF and ERR
+	if !symbols[sep].lexeme || sep <= Symbol(2) {
+		return "'%split' separator has to be a lexeme"
+	}
+	if symbols[list].type != {} && split.code == {} {
+		return "'%split' of a list with a type needs code to merge its values"
+	}
+
+	uses :: proc(rhs: []Symbol, list, sep: Symbol) -> bool {
+		for symbol in rhs {
+			if symbol == list || symbol == sep do return true
+		}
+		return false
+	}
+
+	for rule in rules[1:] {
+		if rule.lhs != list || len(rule.rhs) == 0 || rule.rhs[0] != list {
+			if uses(rule.rhs, list, sep) do return "'%split' list or separator used outside of list -> list separator ..."
+			continue
+		}
+
+		if len(rule.rhs) < 2 || rule.rhs[1] != sep || uses(rule.rhs[2:], list, sep) {
+			return "'%split' list or separator used outside of list -> list separator ..."
+		}
+
+		first := false
+		for other in rules[1:] {
+			if other.lhs == list && slice.equal(other.rhs, rule.rhs[2:]) {
+				first = true
+				break
+			}
+		}
+		if !first do return "'%split' list -> list separator a needs a rule list -> a"
+	}
+	return {}
 }
 
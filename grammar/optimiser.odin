@@ -0,0 +1,115 @@
+package grammar
+
+import "core:strings"
+
+// whether reducing the rule can be skipped: it has a single child of the
+// same type and its code only copies the value, or both are untyped and
+// there is no code at all
+is_unit_rule :: proc(g: Grammar, r: Rule) -> bool {
+	rule := g.rules[r]
+	if r == START || len(rule.rhs) != 1 do return false
+
+	lhs, rhs := g.symbols[rule.lhs], g.symbols[rule.rhs[0]]
+	if lhs.type != rhs.type do return false
+	if lhs.type == {} do return strings.trim_space(rule.code) == {}
+
+	// this = _0, spacing and semicolon aside
+	IDENTITY :: "this=_0"
+	code := strings.trim_right(rule.code, "; \t\r\n")
+	i := 0
+	for c in transmute([]u8)code {
+		switch c {
+		case ' ', '\t', '\r', '\n':
+		case:
+			if i == len(IDENTITY) || IDENTITY[i] != c do return false
+			i += 1
+		}
+	}
+	return i == len(IDENTITY)
+}
+
+// bypasses states that do nothing but reduce a unit rule A -> B: the goto
+// on B is pointed at the goto on A, so the parser never enters them.
+// The states that become unreachable are dropped, the table is replaced.
+skip_unit_rules :: proc(g: Grammar, table: Table) -> Table {
+	// the unit rule reduced by each state, START if there is none
+	unit := make([]Rule, len(table))
+	defer delete(unit)
+
+	for row, i in table {
+		if i == 0 || len(row) == 0 do continue
+
+		r := START
+		for _, decision in row {
+			reduce, ok := decision.(Reduce)
+			if !ok || (r != START && Rule(reduce) != r) {
+				r = START
+				break
+			}
+			r = Rule(reduce)
+		}
+		if is_unit_rule(g, r) do unit[i] = r
+	}
+
+	// chains take one round per link
+	for _ in 0 ..< len(table) {
+		changed := false
+		for &row in table {
+			for _, &decision in row {
+				shift, ok := decision.(Shift)
+				if !ok || unit[shift] == START do continue
+
+				lhs := g.rules[unit[shift]].lhs
+				if next, found := row[lhs]; found {
+					if target, ok := next.(Shift); ok && target != shift {
+						decision = target
+						changed = true
+					}
+				}
+			}
+		}
+		if !changed do break
+	}
+
+	// keep the reachable states in their original order
+	renumber := make([]int, len(table))
+	defer delete(renumber)
+	for &r in renumber do r = -1
+
+	stack := make([dynamic]int)
+	defer delete(stack)
+	append(&stack, 0)
+	renumber[0] = 0
+	for len(stack) > 0 {
+		for _, decision in table[pop(&stack)] {
+			if shift, ok := decision.(Shift); ok && renumber[shift] == -1 {
+				renumber[shift] = 0
+				append(&stack, int(shift))
+			}
+		}
+	}
+
+	count := 0
+	for &r in renumber {
+		if r == -1 do continue
+		r = count
+		count += 1
+	}
+
+	result := make([]map[Symbol]Decision, count)
+	for &row, i in table {
+		if renumber[i] == -1 {
+			delete(row)
+			continue
+		}
+		for _, &decision in row {
+			if shift, ok := decision.(Shift); ok {
+				decision = Shift(renumber[shift])
+			}
+		}
+		result[renumber[i]] = row
+	}
+	delete(table)
+
+	return result
+}
@@ -0,0 +1,111 @@
+package grammar
+
+import "core:slice"
+import "core:strconv"
+import "core:strings"
+
+// runtime counters written by a parser generated with PARCELR_PROFILE
+Profile :: struct {
+	states: []int, // decisions taken in each state
+	rules:  []int, // reductions of each rule, START excluded
+	ids:    []int, // analyser index of each state, set by sort_states
+}
+
+delete_profile :: proc(p: Profile) {
+	delete(p.states)
+	delete(p.rules)
+	delete(p.ids)
+}
+
+// reads the lines written by parser_profile_write, the counts of
+// concatenated profiles are added up
+parse_profile :: proc(d: []u8, g: Grammar, table: Table) -> (Profile, Error) {
+	p := Profile{make([]int, len(table)), make([]int, len(g.rules) - 1), nil}
+
+	rule_matches :: proc(g: Grammar, rule: RuleDefinition, text: []string) -> bool {
+		if len(text) != len(rule.rhs) + 2 do return false
+		if text[0] != g.symbols[rule.lhs].name || text[1] != "->" do return false
+		for symbol, i in rule.rhs {
+			if text[i + 2] != g.symbols[symbol].name do return false
+		}
+		return true
+	}
+
+	data := transmute(string)d
+	for line in strings.split_lines_iterator(&data) {
+		fields := strings.fields(line)
+		defer delete(fields)
+		if len(fields) == 0 do continue
+
+		switch fields[0] {
+		case "parses", "depth":
+		case "state", "rule":
+			if len(fields) < 3 {
+				delete_profile(p)
+				return {}, "malformed profile"
+			}
+			index, ok := strconv.parse_int(fields[1], 10)
+			count, ok2 := strconv.parse_int(fields[2], 10)
+			if !ok || !ok2 {
+				delete_profile(p)
+				return {}, "malformed profile"
+			}
+
+			if fields[0] == "state" {
+				if index < 0 || index >= len(p.states) {
+					delete_profile(p)
+					return {}, "profile does not match the grammar"
+				}
+				p.states[index] += count
+			} else {
+				if index < 0 || index >= len(p.rules) || !rule_matches(g, g.rules[index + 1], fields[3:]) {
+					delete_profile(p)
+					return {}, "profile does not match the grammar"
+				}
+				p.rules[index] += count
+			}
+		case:
+			delete_profile(p)
+			return {}, "malformed profile"
+		}
+	}
+
+	return p, {}
+}
+
+// renumbers the states from most to least visited so hot states are next
+// to each other in the generated code, the start state stays first
+sort_states :: proc(table: Table, p: ^Profile) {
+	Entry :: struct {
+		count: int,
+		index: int,
+	}
+
+	order := make([]Entry, len(table))
+	defer delete(order)
+	for &entry, i in order do entry = {p.states[i], i}
+	slice.stable_sort_by(order[1:], proc(a, b: Entry) -> bool {
+		return a.count > b.count
+	})
+
+	renumber := make([]int, len(table))
+	defer delete(renumber)
+	rows := slice.clone(table)
+	defer delete(rows)
+
+	p.ids = make([]int, len(table))
+	for entry, i in order {
+		renumber[entry.index] = i
+		table[i] = rows[entry.index]
+		p.states[i] = entry.count
+		p.ids[i] = entry.index
+	}
+
+	for &row in table {
+		for _, &decision in row {
+			if shift, ok := decision.(Shift); ok {
+				decision = Shift(renumber[shift])
+			}
+		}
+	}
+}
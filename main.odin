@@ -2,18 +2,146 @@ package main
 
 import "core:fmt"
 import "core:mem"
+import "core:mem/virtual"
 import "core:os"
 import "core:path/filepath"
+import "core:strings"
 
 import "codegen"
 import "grammar"
 
+USAGE :: `parcelr [options] LR0|SLR1|CLR1|LALR1 [grammar] [dir] [templates...]
+
+options:
+  --quiet            only print errors
+  --dump=LIST        comma separated tables to print: grammar, first, follow, table, all, none
+  --arena            allocate the whole run from a single arena, freed in one shot
+  --track            check for leaks and bad frees with a tracking allocator
+  --time             print how long each phase took
+  --stats[=FORMAT]   print time, allocations and analyser counters per phase as text or json,
+                     the peak is the most memory live at once within each phase rather than
+                     over the whole run, json implies --quiet so it is all that is printed
+  --profile=FILE     order states and cases by the counters of a PARCELR_PROFILE build
+  --skip-units       bypass unit rules whose code only copies the value of their child
+  --glr              keep the decisions of conflicting cells for a GLR template instead of failing
+  --emit-tables=FILE write the tables to FILE for templates/c/tables.c, templates become optional`
+
+Dump :: enum {
+	Grammar,
+	First,
+	Follow,
+	Table,
+}
+
+Options :: struct {
+	dump:    bit_set[Dump],
+	quiet:   bool,
+	arena:   bool,
+	track:   bool,
+	time:    bool,
+	stats:   StatsFormat,
+	profile: string,
+	units:   bool,
+	glr:     bool,
+	tables:  string,
+}
+
+parse_options :: proc(args: []string) -> (opts: Options, positional: [dynamic]string, ok: bool) {
+	opts.dump = ~bit_set[Dump]{}
+	opts.track = ODIN_DEBUG
+	positional = make([dynamic]string)
+
+	for arg in args {
+		if !strings.has_prefix(arg, "--") {
+			append(&positional, arg)
+			continue
+		}
+
+		if arg == "--quiet" {
+			opts.quiet = true
+			opts.dump = {}
+		} else if arg == "--arena" {
+			opts.arena = true
+		} else if arg == "--track" {
+			opts.track = true
+		} else if arg == "--time" {
+			opts.time = true
+		} else if arg == "--stats" || arg == "--stats=text" {
+			opts.stats = .Text
+		} else if arg == "--stats=json" {
+			opts.stats = .Json
+		} else if arg == "--skip-units" {
+			opts.units = true
+		} else if arg == "--glr" {
+			opts.glr = true
+		} else if strings.has_prefix(arg, "--emit-tables=") {
+			opts.tables = arg[len("--emit-tables="):]
+		} else if strings.has_prefix(arg, "--profile=") {
+			opts.profile = arg[len("--profile="):]
+		} else if strings.has_prefix(arg, "--dump=") {
+			opts.dump = {}
+			list := arg[len("--dump="):]
+			for name in strings.split_iterator(&list, ",") {
+				switch name {
+				case "grammar":
+					opts.dump += {.Grammar}
+				case "first":
+					opts.dump += {.First}
+				case "follow":
+					opts.dump += {.Follow}
+				case "table":
+					opts.dump += {.Table}
+				case "all":
+					opts.dump = ~bit_set[Dump]{}
+				case "none", "":
+				case:
+					fmt.printf("unknown dump: %s\nsupported: grammar, first, follow, table, all, none\n", name)
+					return opts, positional, false
+				}
+			}
+		} else {
+			fmt.printf("unknown option: %s\n", arg)
+			return opts, positional, false
+		}
+	}
+
+	// the json goes to the same stdout as the dumps, keep it parseable
+	if opts.stats == .Json {
+		opts.quiet = true
+		opts.dump = {}
+	}
+
+	// both renumber the states, which the conflicts refer to
+	if opts.glr && (opts.units || opts.profile != {}) {
+		fmt.println("--glr cannot be combined with --skip-units or --profile")
+		return opts, positional, false
+	}
+
+	// the tables hold one decision per cell, the conflicts would be lost
+	if opts.glr && opts.tables != {} {
+		fmt.println("--glr cannot be combined with --emit-tables")
+		return opts, positional, false
+	}
+
+	return opts, positional, true
+}
+
 main :: proc() {
+	opts, args, ok := parse_options(os.args[1:])
+	defer delete(args)
+	if !ok do return
+
+	if !opts.track {
+		_main(opts, args[:])
+		return
+	}
+
 	track: mem.Tracking_Allocator
 	mem.tracking_allocator_init(&track, context.allocator)
+	defer mem.tracking_allocator_destroy(&track)
 	context.allocator = mem.tracking_allocator(&track)
 
-	_main()
+	_main(opts, args[:])
 
 	for _, leak in track.allocation_map {
 		fmt.printf("%v leaked %v bytes\n", leak.location, leak.size)
@@ -23,14 +151,40 @@ main :: proc() {
 	}
 }
 
-_main :: proc() {
-	if len(os.args) < 5 {
-		fmt.println("parcelr LR0|SLR1|CLR1|LALR1 [grammar] [dir] [templates...]")
+_main :: proc(opts: Options, args: []string) {
+	if len(args) < 4 && !(opts.tables != {} && len(args) >= 2) {
+		fmt.println(USAGE)
 		return
 	}
 
+	// everything below is freed at once when the arena is destroyed,
+	// the individual deletes become no-ops
+	arena: virtual.Arena
+	if opts.arena {
+		if err := virtual.arena_init_growing(&arena); err != nil {
+			fmt.printf("could not create arena: %v\n", err)
+			return
+		}
+	}
+	defer if opts.arena do virtual.arena_destroy(&arena)
+	context.allocator = virtual.arena_allocator(&arena) if opts.arena else context.allocator
+
+	// --time only needs the clock, --stats also counts allocations
+	measure := opts.stats != .None
+	track: mem.Tracking_Allocator
+	tracker: ^mem.Tracking_Allocator
+	if measure {
+		mem.tracking_allocator_init(&track, context.allocator)
+		tracker = &track
+	}
+	defer if measure do mem.tracking_allocator_destroy(&track)
+	context.allocator = mem.tracking_allocator(&track) if measure else context.allocator
+
+	stats: Stats
+	stats_init(&stats, tracker)
+
 	type: grammar.Analyser
-	switch os.args[1] {
+	switch args[0] {
 	case "LR0":
 		type = .LR0
 	case "SLR1":
@@ -44,12 +198,13 @@ _main :: proc() {
 		return
 	}
 
-	file, ok := os.read_entire_file(os.args[2])
+	file, ok := os.read_entire_file(args[1])
 	if !ok {
 		fmt.println("could not parse grammar: unknown file")
 		return
 	}
 	defer delete(file)
+	lap(&stats, .Read)
 
 	g, err := grammar.parse_grammar(file)
 	if err != {} {
@@ -57,17 +212,30 @@ _main :: proc() {
 		return
 	}
 	defer grammar.delete_grammar(g)
-	grammar.print_grammar(g)
-	fmt.println()
+	lap(&stats, .Parse_Grammar)
+
+	if .Grammar in opts.dump {
+		grammar.print_grammar(g)
+		fmt.println()
+	}
+	lap(&stats, .Dump)
 
 	empty := grammar.calc_empty_set(g)
+	lap(&stats, .Empty_Set)
 	first := grammar.calc_first_sets(g, empty)
+	lap(&stats, .First_Sets)
 	follow := grammar.calc_follow_sets(g, first, empty)
+	lap(&stats, .Follow_Sets)
 
-	grammar.print_lookahead_table(g, first)
-	fmt.println()
-	grammar.print_lookahead_table(g, follow)
-	fmt.println()
+	if .First in opts.dump {
+		grammar.print_lookahead_table(g, first)
+		fmt.println()
+	}
+	if .Follow in opts.dump {
+		grammar.print_lookahead_table(g, follow)
+		fmt.println()
+	}
+	lap(&stats, .Dump)
 
 	defer {
 		delete(empty)
@@ -75,18 +243,72 @@ _main :: proc() {
 		delete(follow)
 	}
 
-	table, err2 := grammar.calc_table(g, type, empty, first, follow)
+	// conflicts are only collected for --glr, they fail the table otherwise
+	conflicts: grammar.Conflicts
+	collect: ^grammar.Conflicts
+	if opts.glr do collect = &conflicts
+
+	table, err2 := grammar.calc_table(g, type, empty, first, follow, collect)
 	if err2 != {} {
 		fmt.printf("could not calculate table: %s\n", err2)
 		return
 	}
 	defer grammar.delete_table(table)
-	grammar.print_table(g, table)
-	fmt.println()
+	defer grammar.delete_conflicts(conflicts)
+	lap(&stats, .Table)
+
+	if opts.units do table = grammar.skip_unit_rules(g, table)
+	lap(&stats, .Optimise)
+
+	profile: grammar.Profile
+	if opts.profile != {} {
+		data, ok2 := os.read_entire_file(opts.profile)
+		if !ok2 {
+			fmt.println("could not read profile: unknown file")
+			return
+		}
+		defer delete(data)
+
+		err3: grammar.Error
+		profile, err3 = grammar.parse_profile(data, g, table)
+		if err3 != {} {
+			fmt.printf("could not read profile: %s\n", err3)
+			return
+		}
+		grammar.sort_states(table, &profile)
+	}
+	defer grammar.delete_profile(profile)
+	lap(&stats, .Profile)
+
+	if .Table in opts.dump {
+		grammar.print_table(g, table)
+		fmt.println()
+	}
+	lap(&stats, .Dump)
 
-	out_dir := os.args[3]
+	stats.sizes.rules = len(g.rules)
+	stats.sizes.symbols = len(g.symbols)
+	stats.sizes.lexemes = len(g.lexemes)
+	stats.sizes.states = len(table)
+	for row in table do stats.sizes.entries += len(row)
 
-	for path, index in os.args[4:] {
+	ctx := codegen.make_context(g, table, first, follow, profile, conflicts)
+	defer codegen.delete_context(ctx)
+	lap(&stats, .Eval)
+
+	if opts.tables != {} {
+		blob := codegen.write_tables(ctx)
+		defer delete(blob)
+		if !os.write_entire_file(opts.tables, blob) {
+			fmt.println("could not write tables")
+			return
+		}
+		stats.sizes.output += len(blob)
+		lap(&stats, .Write)
+	}
+
+	templates := args[min(3, len(args)):]
+	for path, index in templates {
 		base := filepath.base(path)
 		template, ok3 := os.read_entire_file(path)
 		if !ok3 {
@@ -101,18 +323,24 @@ _main :: proc() {
 			return
 		}
 		defer codegen.delete_directives(dirs)
+		lap(&stats, .Parse_Template)
 
-		e, ok5 := codegen.eval(dirs, g, table, follow)
+		e, ok5 := codegen.eval(dirs, ctx)
 		if !ok5 {
 			fmt.println("could not evaluate template")
 			return
 		}
 		defer delete(e)
+		lap(&stats, .Eval)
 
 		os.write_entire_file(
-			filepath.join({out_dir, base}, context.temp_allocator),
+			filepath.join({args[2], base}, context.temp_allocator),
 			transmute([]byte)e,
 		)
+		stats.sizes.output += len(e)
+		lap(&stats, .Write)
 	}
-	fmt.println("SUCCESS")
+
+	if !opts.quiet do fmt.println("SUCCESS")
+	print_stats(stats, StatsFormat.Text if opts.time && !measure else opts.stats)
 }
@@ -0,0 +1,164 @@
+package main
+
+import "core:fmt"
+import "core:mem"
+import "core:time"
+
+import "grammar"
+
+Phase :: enum {
+	Read,
+	Parse_Grammar,
+	Empty_Set,
+	First_Sets,
+	Follow_Sets,
+	Table,
+	Optimise,
+	Profile,
+	Dump,
+	Parse_Template,
+	Eval,
+	Write,
+}
+
+PHASE_NAMES := [Phase]string {
+	.Read           = "read",
+	.Parse_Grammar  = "parse_grammar",
+	.Empty_Set      = "calc_empty_set",
+	.First_Sets     = "calc_first_sets",
+	.Follow_Sets    = "calc_follow_sets",
+	.Table          = "calc_table",
+	.Optimise       = "skip_unit_rules",
+	.Profile        = "apply_profile",
+	.Dump           = "dump",
+	.Parse_Template = "parse_template",
+	.Eval           = "eval",
+	.Write          = "write",
+}
+
+StatsFormat :: enum {
+	None,
+	Text,
+	Json,
+}
+
+PhaseStats :: struct {
+	time:        time.Duration,
+	allocations: i64,
+	bytes:       i64,
+	peak:        i64, // highest amount of live memory during the phase
+}
+
+Sizes :: struct {
+	rules:   int,
+	symbols: int,
+	lexemes: int,
+	states:  int,
+	entries: int, // decisions stored in the table
+	output:  int, // bytes of generated code
+}
+
+Stats :: struct {
+	phases:      [Phase]PhaseStats,
+	sizes:       Sizes,
+	track:       ^mem.Tracking_Allocator, // nil when only timing
+	start:       time.Tick,
+	clock:       time.Tick,
+	allocations: i64,
+	bytes:       i64,
+}
+
+stats_init :: proc(s: ^Stats, track: ^mem.Tracking_Allocator) {
+	s.track = track
+	s.start = time.tick_now()
+	s.clock = s.start
+	if track != nil {
+		s.allocations = track.total_allocation_count
+		s.bytes = track.total_memory_allocated
+		track.peak_memory_allocated = track.current_memory_allocated
+	}
+	grammar.counters = {}
+}
+
+// attributes everything since the previous lap to the given phase
+lap :: proc(s: ^Stats, phase: Phase) {
+	now := time.tick_now()
+	p := &s.phases[phase]
+	p.time += time.tick_diff(s.clock, now)
+	s.clock = now
+
+	if t := s.track; t != nil {
+		p.allocations += t.total_allocation_count - s.allocations
+		p.bytes += t.total_memory_allocated - s.bytes
+		p.peak = max(p.peak, t.peak_memory_allocated)
+
+		s.allocations = t.total_allocation_count
+		s.bytes = t.total_memory_allocated
+		t.peak_memory_allocated = t.current_memory_allocated
+	}
+}
+
+print_stats :: proc(s: Stats, format: StatsFormat) {
+	total := time.tick_diff(s.start, s.clock)
+	c := grammar.counters
+
+	switch format {
+	case .None:
+	case .Text:
+		if s.track != nil {
+			fmt.printf("%-18s %12s %10s %12s %12s\n", "phase", "time", "allocs", "bytes", "peak")
+		} else {
+			fmt.printf("%-18s %12s\n", "phase", "time")
+		}
+		for p, phase in s.phases {
+			ms := time.duration_milliseconds(p.time)
+			if s.track != nil {
+				fmt.printf("%-18s %10.3fms %10d %12d %12d\n", PHASE_NAMES[phase], ms, p.allocations, p.bytes, p.peak)
+			} else {
+				fmt.printf("%-18s %10.3fms\n", PHASE_NAMES[phase], ms)
+			}
+		}
+		fmt.printf("%-18s %10.3fms\n", "total", time.duration_milliseconds(total))
+		fmt.println()
+		fmt.printf("rules %d, symbols %d, lexemes %d\n", s.sizes.rules, s.sizes.symbols, s.sizes.lexemes)
+		fmt.printf("states %d, table entries %d, output bytes %d\n", s.sizes.states, s.sizes.entries, s.sizes.output)
+		fmt.printf(
+			"closures %d, items examined %d, states created %d, lalr merges %d\n",
+			c.closures,
+			c.items,
+			c.states,
+			c.lalr_merges,
+		)
+	case .Json:
+		fmt.print("{\"phases\":{")
+		for p, phase in s.phases {
+			if phase != min(Phase) do fmt.print(",")
+			fmt.printf(
+				"\"%s\":{\"time_ns\":%d,\"allocations\":%d,\"bytes\":%d,\"peak_bytes\":%d}",
+				PHASE_NAMES[phase],
+				i64(p.time),
+				p.allocations,
+				p.bytes,
+				p.peak,
+			)
+		}
+		fmt.printf("},\"total_ns\":%d", i64(total))
+		fmt.printf(
+			",\"sizes\":{\"rules\":%d,\"symbols\":%d,\"lexemes\":%d,\"states\":%d,\"table_entries\":%d,\"output_bytes\":%d}",
+			s.sizes.rules,
+			s.sizes.symbols,
+			s.sizes.lexemes,
+			s.sizes.states,
+			s.sizes.entries,
+			s.sizes.output,
+		)
+		fmt.printf(
+			",\"counters\":{\"closures\":%d,\"items\":%d,\"states\":%d,\"lalr_merges\":%d}",
+			c.closures,
+			c.items,
+			c.states,
+			c.lalr_merges,
+		)
+		fmt.println("}")
+	}
+}
@@ -0,0 +1,736 @@
+#include "glr.h"
+
+/* bytes in each block of the forest and stack pools */
+#ifndef PARCELR_GLR_BLOCK
+  #define PARCELR_GLR_BLOCK 65536
+#endif
+
+/* reductions done while there is a single stack run their code right away
+   and keep only the value, unless the whole forest is asked for with
+   PARCELR_GLR_FOREST */
+
+struct glr_block {
+  struct glr_block *next;
+  size_t            size;
+  max_align_t       data[];
+};
+
+static void *glr_alloc(struct glr_pool *pool, size_t size) {
+  size = (size + sizeof(max_align_t) - 1) / sizeof(max_align_t) * sizeof(max_align_t);
+
+  struct glr_block *block = pool->blocks;
+  if (block == NULL || pool->used + size > block->size) {
+    size_t capacity = size > PARCELR_GLR_BLOCK ? size : PARCELR_GLR_BLOCK;
+    block = (struct glr_block*)PARCELR_REALLOC(pool->context, NULL, sizeof(struct glr_block) + capacity);
+    block->next = pool->blocks;
+    block->size = capacity;
+    pool->blocks = block;
+    pool->used = 0;
+  }
+
+  void *data = (char*)block->data + pool->used;
+  pool->used += size;
+  return data;
+}
+
+static void glr_pool_destroy(struct glr_pool *pool) {
+  while (pool->blocks) {
+    struct glr_block *next = pool->blocks->next;
+    PARCELR_FREE(pool->context, pool->blocks);
+    pool->blocks = next;
+  }
+  pool->used = 0;
+}
+
+void glr_forest_destroy(struct glr_forest *forest) {
+  glr_pool_destroy(&forest->_pool);
+  forest->root = NULL;
+}
+
+/* decisions of the table, shifts are even and reductions odd */
+#define GLR_ERROR        (-1)
+#define GLR_ACCEPT       (-2)
+#define GLR_SHIFT(state) ((state) * 2)
+#define GLR_REDUCE(rule) ((rule) * 2 + 1)
+
+static const struct {
+  parser_symbol_id lhs;
+  unsigned         length;
+} glr_rules[] = {
+//rule
+  //l { SYMBOL_${rule.lhs.enum}, ${rule.rhs.length} },
+//e
+};
+
+/* the decision the table kept for a lexeme */
+static int glr_action(int state, parser_symbol symbol) {
+  switch (state) {
+  //state
+    //l case ${state.index}:
+      //l switch (symbol) {
+  //state.action lah
+  //lah.symbol
+        //l case SYMBOL_${symbol.enum}:
+  //e
+  //lah.accept
+          //l return GLR_ACCEPT;
+  //e
+  //lah.shift
+          //l return GLR_SHIFT(${shift});
+  //e
+  //lah.reduce
+          //l return GLR_REDUCE(${reduce.index});
+  //e
+  //e
+        //l default: return GLR_ERROR;
+      //l }
+  //e
+  }
+  return GLR_ERROR;
+}
+
+/* states with a conflicting cell */
+static const bool glr_conflicted[] = {
+//state
+  //w  ${state.conflict.length}
+  //s ,
+//e
+//w  };
+
+/* the decisions the table left out, ended by GLR_ERROR, or NULL when the
+   cell has a single decision */
+static const int *glr_conflicts(int state, parser_symbol symbol) {
+  if (!glr_conflicted[state]) return NULL;
+  switch (state) {
+  //state
+  //state.conflict.length
+    //l case ${state.index}:
+      //l switch (symbol) {
+  //state.conflict c
+  //c.symbol
+        //l case SYMBOL_${symbol.enum}: { static const int decisions[] = {
+  //e
+  //c.accept
+        //w  GLR_ACCEPT,
+  //e
+  //c.reduce
+        //w  GLR_REDUCE(${reduce.index}),
+  //e
+        //w  GLR_ERROR }; return decisions; }
+  //e
+        //l default: break;
+      //l }
+      //l break;
+  //e
+  //e
+  }
+  return NULL;
+}
+
+/* the state entered after reducing to a nonterminal */
+static int glr_goto(int state, parser_symbol symbol) {
+  switch (state) {
+  //state
+  //state.goto.length
+    //l case ${state.index}:
+      //l switch (symbol) {
+  //state.goto g
+  //g.shift
+  //g.symbol
+        //l case SYMBOL_${symbol.enum}: return ${shift};
+  //e
+  //e
+  //e
+        //l default: break;
+      //l }
+      //l break;
+  //e
+  //e
+  }
+  return -1;
+}
+
+/* takes the next lexeme and its value off the input */
+static void glr_take(struct stack_s *symbols, struct glr_node *node) {
+  switch (stack_pop(*symbols, parser_symbol)) {
+  //symbol
+  //symbol.lexeme
+  //symbol.type
+    //l case SYMBOL_${symbol.enum}: node->value._${symbol.type_index} = stack_pop(*symbols, ${type}); break;
+  //e
+  //e
+  //e
+    default: break;
+  }
+}
+
+/* runs the code of a rule over the values of its children */
+static void glr_code(unsigned rule, struct glr_node **children, glr_value *out PARCELR_CONTEXT_PARAM) {
+  (void)children;
+  (void)out;
+#ifdef PARCELR_CONTEXT
+  (void)context;
+#endif
+  switch (rule) {
+  //rule
+    //l case ${rule.index}:
+    //l {
+    //rule.rhs child index
+    //child.type
+      //l ${type} _${index} = children[${index}]->value._${child.type_index};
+    //e
+    //e
+    //rule.lhs.type
+      //l ${type} this;
+      //rule.code
+        //w  ${code}
+      //e
+      //l out->_${rule.lhs.type_index} = this;
+    //e
+      //l break;
+    //l }
+  //e
+  }
+}
+
+/* a node of the graph structured stack, a plain LR stack as long as every
+   node has a single link */
+struct glr_gss {
+  parser_state     state;
+  unsigned         position;
+  unsigned         refs;  /* links to the node, plus one while it is a top */
+  struct glr_link *links;
+  struct glr_gss  *next;  /* free list */
+};
+
+struct glr_link {
+  struct glr_gss  *to;
+  struct glr_node *node;  /* the symbol between both states */
+  struct glr_link *next;
+};
+
+/* a reduction to do on the paths down from a top, when via is set only
+   the paths through that link */
+struct glr_reduction {
+  struct glr_gss  *top;
+  struct glr_link *via;
+  unsigned         rule;
+};
+
+/* the tops of the position by state, so reductions find them without a
+   scan. An entry only counts while its stamp is the position + 1 */
+struct glr_top {
+  struct glr_gss *node;
+  unsigned        stamp;
+};
+
+/* what the reductions of the position made, by a hash of what they were
+   made from. Open addressing over a power of two slots kept at most half
+   full, stamped like the tops so the index empties whenever the position
+   moves on */
+struct glr_slot {
+  void    *key;
+  void    *value;
+  uint64_t hash;
+  unsigned stamp;
+};
+
+struct glr_index {
+  struct glr_slot *slots;
+  unsigned         mask;
+  unsigned         length;
+  unsigned         stamp;  /* of the length */
+};
+
+#define GLR_STATES (sizeof(glr_conflicted) / sizeof(*glr_conflicted))
+
+struct glr_parser {
+  void              *context;
+  struct glr_forest *forest;
+  struct glr_pool    pool;  /* stack nodes and links, reused through the free lists */
+  struct glr_gss    *free_gss;
+  struct glr_link   *free_links;
+
+  typed_stack_s(struct glr_gss*)      tops;
+  typed_stack_s(struct glr_gss*)      shifted;  /* the tops after the next shift */
+  typed_stack_s(struct glr_gss*)      dead;     /* nodes left to release */
+  typed_stack_s(struct glr_node*)     free_nodes;
+  typed_stack_s(struct glr_reduction) todo;
+
+  struct glr_top   *top_of;  /* per state */
+  struct glr_index  made;    /* nonterminals ending at the position by symbol and start */
+  struct glr_index  joins;   /* links down from the tops by the node below and symbol */
+  struct glr_index  packs;   /* derivations of the nonterminals in made by rule and children */
+
+  struct glr_node **children;
+  struct glr_gss   *accepted;
+  unsigned          position;
+  parser_symbol     next;
+};
+
+static struct glr_gss *glr_gss_make(struct glr_parser *p, int state) {
+  struct glr_gss *node = p->free_gss;
+  if (node) {
+    p->free_gss = node->next;
+  } else {
+    node = (struct glr_gss*)glr_alloc(&p->pool, sizeof(struct glr_gss));
+  }
+  node->state = (parser_state)state;
+  node->position = p->position;
+  node->refs = 1;
+  node->links = NULL;
+  return node;
+}
+
+static struct glr_link *glr_link_make(struct glr_parser *p, struct glr_gss *from, struct glr_gss *to, struct glr_node *node) {
+  struct glr_link *link = p->free_links;
+  if (link) {
+    p->free_links = link->next;
+  } else {
+    link = (struct glr_link*)glr_alloc(&p->pool, sizeof(struct glr_link));
+  }
+  link->to = to;
+  link->node = node;
+  link->next = from->links;
+  from->links = link;
+  to->refs++;
+  return link;
+}
+
+/* drops a reference, nodes nothing refers to go back to the free lists.
+   Single links are followed in place, only forks go through the dead stack */
+static void glr_release(struct glr_parser *p, struct glr_gss *node) {
+  while (true) {
+    while (--node->refs == 0) {
+      struct glr_link *link = node->links;
+      node->next = p->free_gss;
+      p->free_gss = node;
+      if (link == NULL) break;
+
+      struct glr_link *last = link;
+      for (; last->next; last = last->next) {
+        typed_stack_push_in(p->context, p->dead, last->next->to);
+      }
+      last->next = p->free_links;
+      p->free_links = link;
+      node = link->to;
+    }
+    if (p->dead.length == 0) return;
+    node = typed_stack_pop(p->dead);
+  }
+}
+
+static struct glr_node *glr_node_make(struct glr_parser *p, parser_symbol symbol, unsigned start) {
+  struct glr_node *node;
+  if (p->free_nodes.length > 0) {
+    node = typed_stack_pop(p->free_nodes);
+  } else {
+    node = (struct glr_node*)glr_alloc(&p->forest->_pool, sizeof(struct glr_node));
+  }
+  node->symbol = symbol;
+  node->start = start;
+  node->end = p->position;
+  node->packed = NULL;
+  node->evaluated = false;
+  node->shared = false;
+  return node;
+}
+
+static uint64_t glr_hash(uint64_t hash, uint64_t value) {
+  hash = (hash ^ value) * 0x9e3779b97f4a7c15u;
+  return hash ^ hash >> 32;
+}
+
+/* the next slot under the hash from *at on, NULL after the last */
+static struct glr_slot *glr_index_next(struct glr_parser *p, struct glr_index *index, uint64_t hash, unsigned *at) {
+  if (index->slots == NULL) return NULL;
+  for (; index->slots[*at].stamp == p->position + 1; *at = (*at + 1) & index->mask) {
+    struct glr_slot *slot = &index->slots[*at];
+    if (slot->hash == hash) {
+      *at = (*at + 1) & index->mask;
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+static void glr_index_put(struct glr_index *index, struct glr_slot slot) {
+  unsigned at = (unsigned)slot.hash & index->mask;
+  while (index->slots[at].stamp == slot.stamp) at = (at + 1) & index->mask;
+  index->slots[at] = slot;
+  index->length++;
+}
+
+static void glr_index_add(struct glr_parser *p, struct glr_index *index, uint64_t hash, void *key, void *value) {
+  unsigned stamp = p->position + 1;
+  if (index->stamp != stamp) {
+    index->stamp = stamp;
+    index->length = 0;
+  }
+
+  if (index->slots == NULL || (index->length + 1) * 2 > index->mask + 1) {
+    struct glr_index grown = { .mask = index->slots ? index->mask * 2 + 1 : 63, .stamp = stamp };
+    grown.slots = (struct glr_slot*)PARCELR_REALLOC(p->context, NULL, sizeof(struct glr_slot) * (grown.mask + 1));
+    memset(grown.slots, 0, sizeof(struct glr_slot) * (grown.mask + 1));
+    for (unsigned i = 0; index->slots && i <= index->mask; i++) {
+      if (index->slots[i].stamp == stamp) glr_index_put(&grown, index->slots[i]);
+    }
+    PARCELR_FREE(p->context, index->slots);
+    *index = grown;
+  }
+  glr_index_put(index, (struct glr_slot){ key, value, hash, stamp });
+}
+
+static uint64_t glr_made_hash(parser_symbol symbol, unsigned start) {
+  return glr_hash(glr_hash(0, (uint64_t)symbol), start);
+}
+
+static struct glr_node *glr_made_find(struct glr_parser *p, parser_symbol symbol, unsigned start) {
+  uint64_t hash = glr_made_hash(symbol, start);
+  unsigned at = (unsigned)hash & p->made.mask;
+  for (struct glr_slot *slot; (slot = glr_index_next(p, &p->made, hash, &at));) {
+    struct glr_node *node = (struct glr_node*)slot->value;
+    if (node->symbol == symbol && node->start == start) return node;
+  }
+  return NULL;
+}
+
+static void glr_made_add(struct glr_parser *p, struct glr_node *node) {
+  glr_index_add(p, &p->made, glr_made_hash(node->symbol, node->start), NULL, node);
+}
+
+static uint64_t glr_join_hash(struct glr_gss *to, parser_symbol symbol) {
+  return glr_hash(glr_hash(0, (uintptr_t)to), (uint64_t)symbol);
+}
+
+/* the link of a top down to the node over the symbol, the top is the only
+   one of its state at the position so there is at most one */
+static struct glr_link *glr_join_find(struct glr_parser *p, struct glr_gss *to, parser_symbol symbol) {
+  uint64_t hash = glr_join_hash(to, symbol);
+  unsigned at = (unsigned)hash & p->joins.mask;
+  for (struct glr_slot *slot; (slot = glr_index_next(p, &p->joins, hash, &at));) {
+    struct glr_link *link = (struct glr_link*)slot->value;
+    if (link->to == to && link->node->symbol == symbol) return link;
+  }
+  return NULL;
+}
+
+static void glr_join_add(struct glr_parser *p, struct glr_link *link) {
+  glr_index_add(p, &p->joins, glr_join_hash(link->to, link->node->symbol), NULL, link);
+}
+
+static void glr_pack(struct glr_parser *p, struct glr_node *node, unsigned rule, struct glr_node **children) {
+  unsigned length = glr_rules[rule].length;
+
+  uint64_t hash = glr_hash(glr_hash(0, (uintptr_t)node), rule);
+  for (unsigned i = 0; i < length; i++) {
+    hash = glr_hash(hash, (uintptr_t)children[i]);
+  }
+  unsigned at = (unsigned)hash & p->packs.mask;
+  for (struct glr_slot *slot; (slot = glr_index_next(p, &p->packs, hash, &at));) {
+    struct glr_packed *packed = (struct glr_packed*)slot->value;
+    if (slot->key == node && packed->rule == rule && memcmp(packed->children, children, sizeof(struct glr_node*) * length) == 0) return;
+  }
+  for (unsigned i = 0; i < length; i++) {
+    children[i]->shared = true;
+  }
+
+  struct glr_packed *packed = (struct glr_packed*)glr_alloc(&p->forest->_pool, sizeof(struct glr_packed));
+  packed->rule = rule;
+  packed->length = length;
+  packed->children = (struct glr_node**)glr_alloc(&p->forest->_pool, sizeof(struct glr_node*) * length);
+  memcpy(packed->children, children, sizeof(struct glr_node*) * length);
+  glr_index_add(p, &p->packs, hash, node, packed);
+
+  /* the first derivation stays first, it is the one glr_eval runs */
+  if (node->packed) {
+    packed->next = node->packed->next;
+    node->packed->next = packed;
+  } else {
+    packed->next = NULL;
+    node->packed = packed;
+  }
+}
+
+static void glr_schedule(struct glr_parser *p, struct glr_gss *top, struct glr_link *via) {
+  int decision = glr_action(top->state, p->next);
+  const int *more = glr_conflicts(top->state, p->next);
+  while (true) {
+    if (decision == GLR_ACCEPT) {
+      p->accepted = top;
+    } else if (decision >= 0 && decision % 2 == 1) {
+      unsigned rule = (unsigned)decision / 2;
+      if (via == NULL || glr_rules[rule].length > 0) {
+        struct glr_reduction reduction = {top, via, rule};
+        typed_stack_push_in(p->context, p->todo, reduction);
+      }
+    }
+    if (more == NULL || *more == GLR_ERROR) break;
+    decision = *more++;
+  }
+}
+
+/* reduces one path, the nonterminal is shared with the other reductions
+   over the same lexemes and the new link is followed by earlier tops */
+static void glr_reduce(struct glr_parser *p, struct glr_gss *left, unsigned rule) {
+  parser_symbol lhs = (parser_symbol)glr_rules[rule].lhs;
+  int state = glr_goto(left->state, lhs);
+
+  struct glr_gss *top = p->top_of[state].stamp == p->position + 1 ? p->top_of[state].node : NULL;
+
+  /* the stacks already join here, only the derivation is new */
+  if (top) {
+    struct glr_link *link = glr_join_find(p, left, lhs);
+    if (link) {
+      glr_pack(p, link->node, rule, p->children);
+      return;
+    }
+  }
+
+  struct glr_node *node = glr_made_find(p, lhs, left->position);
+  if (node == NULL) {
+    node = glr_node_make(p, lhs, left->position);
+    node->shared = true;
+    glr_made_add(p, node);
+  }
+  glr_pack(p, node, rule, p->children);
+
+  if (top) {
+    struct glr_link *link = glr_link_make(p, top, left, node);
+    glr_join_add(p, link);
+    for (unsigned i = 0; i < p->tops.length; i++) {
+      glr_schedule(p, p->tops.data[i], link);
+    }
+    return;
+  }
+
+  top = glr_gss_make(p, state);
+  glr_join_add(p, glr_link_make(p, top, left, node));
+  typed_stack_push_in(p->context, p->tops, top);
+  p->top_of[state] = (struct glr_top){ top, p->position + 1 };
+  glr_schedule(p, top, NULL);
+}
+
+static void glr_paths(struct glr_parser *p, struct glr_gss *node, unsigned rule, unsigned left, struct glr_link *via) {
+  /* via leaves a top, paths only go down to earlier positions from there */
+  if (via && node->position < p->position) return;
+  if (left == 0) {
+    if (via == NULL) glr_reduce(p, node, rule);
+    return;
+  }
+  for (struct glr_link *link = node->links; link; link = link->next) {
+    p->children[left - 1] = link->node;
+    glr_paths(p, link->to, rule, left - 1, link == via ? NULL : via);
+  }
+}
+
+static struct glr_node *glr_leaf(struct glr_parser *p, struct stack_s *symbols) {
+  struct glr_node *leaf = glr_node_make(p, p->next, p->position);
+  leaf->end = p->position + 1;
+  leaf->evaluated = true;
+  glr_take(symbols, leaf);
+  return leaf;
+}
+
+bool glr_parse(struct stack_s symbols, struct glr_forest *forest PARCELR_CONTEXT_PARAM) {
+  struct glr_parser p = {0};
+  p.context = PARCELR_CONTEXT_PTR;
+  p.pool.context = p.context;
+  p.forest = forest;
+  forest->root = NULL;
+  forest->_pool = (struct glr_pool){ .context = p.context };
+
+  unsigned longest = 1;
+  for (unsigned i = 0; i < sizeof(glr_rules) / sizeof(*glr_rules); i++) {
+    if (glr_rules[i].length > longest) longest = glr_rules[i].length;
+  }
+  p.children = (struct glr_node**)PARCELR_REALLOC(p.context, NULL, sizeof(struct glr_node*) * longest);
+  p.top_of = (struct glr_top*)PARCELR_REALLOC(p.context, NULL, sizeof(struct glr_top) * GLR_STATES);
+  memset(p.top_of, 0, sizeof(struct glr_top) * GLR_STATES);
+
+  typed_stack_push_in(p.context, p.tops, glr_gss_make(&p, 0));
+
+  while (true) {
+    p.next = stack_peek(symbols, parser_symbol);
+
+    /* a single stack and a single decision, step like an LR parser and
+       only fall back when a reduction has more than one path */
+    if (p.tops.length == 1) {
+      struct glr_gss *top = p.tops.data[0];
+      if (glr_conflicts(top->state, p.next) == NULL) {
+        int decision = glr_action(top->state, p.next);
+
+        if (decision == GLR_ERROR) break;
+        if (decision == GLR_ACCEPT) {
+          forest->root = top->links->node;
+          break;
+        }
+
+        if (decision % 2 == 0) {
+          struct glr_node *leaf = glr_leaf(&p, &symbols);
+          struct glr_gss *shifted = glr_gss_make(&p, decision / 2);
+          shifted->position++;
+          glr_link_make(&p, shifted, top, leaf);
+          glr_release(&p, top);
+          p.tops.data[0] = shifted;
+          p.position++;
+          continue;
+        }
+
+        unsigned rule = (unsigned)decision / 2;
+        struct glr_gss *left = top;
+        unsigned i = glr_rules[rule].length;
+        while (i > 0 && left->links->next == NULL) {
+          p.children[--i] = left->links->node;
+          left = left->links->to;
+        }
+
+        if (i == 0) {
+          parser_symbol lhs = (parser_symbol)glr_rules[rule].lhs;
+          struct glr_node *node = glr_node_make(&p, lhs, left->position);
+          bool ready = false;
+#ifndef PARCELR_GLR_FOREST
+          /* the children only hang off the popped links unless a
+             derivation or another stack holds them as well */
+          ready = true;
+          for (unsigned j = 0; j < glr_rules[rule].length; j++) {
+            ready = ready && p.children[j]->evaluated;
+          }
+          if (ready) {
+            glr_code(rule, p.children, &node->value PARCELR_CONTEXT_ARG);
+            node->evaluated = true;
+            for (unsigned j = 0; j < glr_rules[rule].length; j++) {
+              if (!p.children[j]->shared) typed_stack_push_in(p.context, p.free_nodes, p.children[j]);
+            }
+          }
+#endif
+          if (!ready) {
+            glr_pack(&p, node, rule, p.children);
+            node->shared = true;
+            glr_made_add(&p, node);
+          }
+
+          struct glr_gss *reduced = glr_gss_make(&p, glr_goto(left->state, lhs));
+          glr_link_make(&p, reduced, left, node);
+          glr_release(&p, top);
+          p.tops.data[0] = reduced;
+          continue;
+        }
+      }
+    }
+
+    /* reduce every stack as far as it goes, then shift them together. The
+       single stack path replaces tops without indexing them, so the index
+       starts from the tops and their links here */
+    p.accepted = NULL;
+    for (unsigned i = 0; i < p.tops.length; i++) {
+      struct glr_gss *top = p.tops.data[i];
+      p.top_of[top->state] = (struct glr_top){ top, p.position + 1 };
+      for (struct glr_link *link = top->links; link; link = link->next) {
+        glr_join_add(&p, link);
+      }
+    }
+    for (unsigned i = 0; i < p.tops.length; i++) {
+      glr_schedule(&p, p.tops.data[i], NULL);
+    }
+    while (p.todo.length > 0) {
+      struct glr_reduction reduction = typed_stack_pop(p.todo);
+      glr_paths(&p, reduction.top, reduction.rule, glr_rules[reduction.rule].length, reduction.via);
+    }
+
+    if (p.next == SYMBOL_EOF) {
+      if (p.accepted) forest->root = p.accepted->links->node;
+      break;
+    }
+
+    struct glr_node *leaf = NULL;
+    p.shifted.length = 0;
+    for (unsigned i = 0; i < p.tops.length; i++) {
+      struct glr_gss *top = p.tops.data[i];
+      int decision = glr_action(top->state, p.next);
+      if (decision < 0 || decision % 2 == 1) continue;
+      if (leaf == NULL) {
+        leaf = glr_leaf(&p, &symbols);
+        leaf->shared = true;
+      }
+
+      struct glr_gss *shifted = NULL;
+      for (unsigned j = 0; j < p.shifted.length; j++) {
+        if (p.shifted.data[j]->state == decision / 2) shifted = p.shifted.data[j];
+      }
+      if (shifted == NULL) {
+        shifted = glr_gss_make(&p, decision / 2);
+        shifted->position++;
+        typed_stack_push_in(p.context, p.shifted, shifted);
+      }
+      glr_link_make(&p, shifted, top, leaf);
+    }
+
+    for (unsigned i = 0; i < p.tops.length; i++) {
+      glr_release(&p, p.tops.data[i]);
+    }
+    p.tops.length = 0;
+    for (unsigned i = 0; i < p.shifted.length; i++) {
+      typed_stack_push_in(p.context, p.tops, p.shifted.data[i]);
+    }
+    p.position++;
+
+    if (p.tops.length == 0) break;
+  }
+
+  PARCELR_FREE(p.context, p.children);
+  PARCELR_FREE(p.context, p.tops.data);
+  PARCELR_FREE(p.context, p.shifted.data);
+  PARCELR_FREE(p.context, p.dead.data);
+  PARCELR_FREE(p.context, p.free_nodes.data);
+  PARCELR_FREE(p.context, p.todo.data);
+  PARCELR_FREE(p.context, p.top_of);
+  PARCELR_FREE(p.context, p.made.slots);
+  PARCELR_FREE(p.context, p.joins.slots);
+  PARCELR_FREE(p.context, p.packs.slots);
+  glr_pool_destroy(&p.pool);
+
+  if (forest->root == NULL) {
+    glr_forest_destroy(forest);
+    return false;
+  }
+  return true;
+}
+
+void glr_eval(struct glr_forest *forest PARCELR_CONTEXT_PARAM) { //d
+//l void glr_eval(struct glr_forest *forest
+//rule.0.lhs.type
+  //w , ${type} *value
+//e
+//w  PARCELR_CONTEXT_PARAM) {
+  typed_stack_s(struct glr_node*) todo = {0};
+  typed_stack_push_in(PARCELR_CONTEXT_PTR, todo, forest->root);
+
+  /* children first, left to right */
+  while (todo.length > 0) {
+    struct glr_node *node = todo.data[todo.length - 1];
+    if (node->evaluated) {
+      todo.length--;
+      continue;
+    }
+
+    struct glr_packed *packed = node->packed;
+    bool ready = true;
+    for (unsigned i = packed->length; i-- > 0;) {
+      if (!packed->children[i]->evaluated) {
+        typed_stack_push_in(PARCELR_CONTEXT_PTR, todo, packed->children[i]);
+        ready = false;
+      }
+    }
+    if (!ready) continue;
+
+    todo.length--;
+    glr_code(packed->rule, packed->children, &node->value PARCELR_CONTEXT_ARG);
+    node->evaluated = true;
+  }
+  PARCELR_FREE(PARCELR_CONTEXT_PTR, todo.data);
+
+//rule.0.lhs.type
+  //l *value = forest->root->value._${rule.0.lhs.type_index};
+//e
+}
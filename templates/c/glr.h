@@ -0,0 +1,64 @@
+#pragma once
+
+#include "parser.h"
+
+/* a GLR parser for grammars generated with parcelr --glr: every decision of
+   a conflicting cell is followed at once and all parses end up in a shared
+   packed parse forest. Where a single stack is left the rule code runs
+   right away, the rest waits for glr_eval to run it over the first
+   derivation of each node. Error rules are not used, the first lexeme no
+   stack can shift fails the parse */
+
+typedef union {
+  char _none;
+//type type index
+//l   ${type} _${index};
+//e
+} glr_value;
+
+/* a symbol spanning the lexemes [start, end), lexemes carry their value
+   and nonterminals one packed node per derivation, or only their value
+   when they were reduced on a single stack */
+struct glr_node {
+  parser_symbol      symbol;
+  unsigned           start, end;
+  struct glr_packed *packed;
+  bool               evaluated;
+  bool               shared;  /* held by a derivation or several stacks */
+  glr_value          value;
+};
+
+struct glr_packed {
+  unsigned           rule;   /* index into the rules, as in parser_rules */
+  unsigned           length;
+  struct glr_node  **children;
+  struct glr_packed *next;   /* the next derivation of the same node */
+};
+
+/* blocks everything is bump allocated from, freed in one go */
+struct glr_pool {
+  struct glr_block *blocks;
+  size_t            used;
+  void             *context;  /* the blocks are allocated with */
+};
+
+struct glr_forest {
+  struct glr_node *root;
+  struct glr_pool  _pool;
+};
+
+/* returns false and an empty forest on a syntax error */
+bool glr_parse(struct stack_s lexemes, struct glr_forest *forest PARCELR_CONTEXT_PARAM);
+
+/* nodes shared by several derivations are evaluated once, so values
+   owning memory end up shared as well. With PARCELR_CONTEXT both this and
+   glr_parse take the context, as either may run rule code */
+void glr_eval(struct glr_forest *forest PARCELR_CONTEXT_PARAM); //d
+//l void glr_eval(struct glr_forest *forest
+//rule.0.lhs.type
+  //w , ${type} *value
+//e
+//w  PARCELR_CONTEXT_PARAM);
+
+/* frees the forest with the context of the parse that made it */
+void glr_forest_destroy(struct glr_forest *forest);
@@ -1,5 +1,21 @@
 #include "parser.h"
 
+#if defined(__GNUC__) && !defined(__clang__)
+  #define PARCELR_COLD __attribute__((cold))
+#else
+  #define PARCELR_COLD
+#endif
+
+/* called with the state and lexeme of every syntax error */
+#ifndef PARCELR_REPORT_ERROR
+  #define PARCELR_REPORT_ERROR(state, symbol)
+#endif
+
+/* lexemes skipped to resynchronise after an error before giving up */
+#ifndef PARCELR_MAX_DISCARD
+  #define PARCELR_MAX_DISCARD 256
+#endif
+
 const char *parser_symbol_name(parser_symbol symbol) {
   switch (symbol) {
     case SYMBOL_EOF: return "EOF"; //d
@@ -11,52 +27,261 @@ const char *parser_symbol_name(parser_symbol symbol) {
   return "";
 }
 
-bool parser_parse(struct stack_s symbols) { //d
+#ifdef PARCELR_PROFILE
+parser_profile parser_profile_data;
+
+const struct parser_rule parser_rules[PARCELR_RULES] = {
+//rule
+  //l { SYMBOL_${rule.lhs.enum}, ${rule.rhs.length}, (const parser_symbol_id[]){
+  //rule.rhs
+    //w  SYMBOL_${rhs.enum}
+    //s ,
+  //e
+  //rule.rhs.length."0"
+    //w  SYMBOL_EOF
+  //e
+  //w  } },
+//e
+};
+
+/* states are written with the index the analyser gave them, which stays
+   the same when parcelr --profile renumbers them */
+static const parser_state parser_state_ids[PARCELR_STATES] = {
+//state
+  //w  ${state.id}
+  //s ,
+//e
+//w  };
+
+/* one line per counter, rules are followed by their text:
+   parses N, depth N, state ID N, rule INDEX N LHS -> RHS... */
+void parser_profile_write(FILE *file, const parser_profile *profile) {
+  fprintf(file, "parses %lu\n", profile->parses);
+  fprintf(file, "depth %u\n", profile->max_depth);
+  for (unsigned i = 0; i < PARCELR_STATES; i++) {
+    fprintf(file, "state %u %lu\n", (unsigned)parser_state_ids[i], profile->states[i]);
+  }
+  for (unsigned i = 0; i < PARCELR_RULES; i++) {
+    const struct parser_rule *rule = &parser_rules[i];
+    fprintf(file, "rule %u %lu %s ->", i, profile->rules[i], parser_symbol_name((parser_symbol)rule->lhs));
+    for (unsigned j = 0; j < rule->length; j++) {
+      fprintf(file, " %s", parser_symbol_name((parser_symbol)rule->rhs[j]));
+    }
+    fprintf(file, "\n");
+  }
+}
+#endif
+
+/* states with an action on error, bit i of word i / 32 */
+static const uint32_t parser_error_mask[] = {
+//error_mask
+  //w  ${error_mask}
+  //s ,
+//e
+//w  };
+
+/* drops the next lexeme and its value from the input */
+static void parser_discard(struct stack_s *symbols) {
+  switch (stack_pop(*symbols, parser_symbol)) {
+  //symbol
+  //symbol.lexeme
+  //symbol.type
+    //l case SYMBOL_${symbol.enum}: _stack_pop(symbols, sizeof(${type})); break;
+  //e
+  //e
+  //e
+    default: break;
+  }
+}
+
+#ifdef PARCELR_TAPE
+void parser_tape_destroy(struct parser_tape *tape) {
+  PARCELR_FREE(tape->_context, tape->data);
+  tape->data = NULL;
+  tape->length = 0;
+  tape->_capacity = 0;
+}
+#endif
+
+/* the state entered after reducing to a nonterminal */
+static int parser_goto(int state, parser_symbol symbol) {
+  switch (state) {
+  //state
+  //state.goto.length
+    //l case ${state.index}:
+      //l switch (symbol) {
+  //state.goto g
+  //g.shift
+  //g.symbol
+        //l case SYMBOL_${symbol.enum}: return ${shift};
+  //e
+  //e
+  //e
+        //l default: break;
+      //l }
+      //l break;
+  //e
+  //e
+  }
+  return -1;
+}
+
+#ifdef PARCELR_TAPE
+bool parser_parse(struct stack_s symbols, struct parser_tape *tape PARCELR_CONTEXT_PARAM) {
+#else
+bool parser_parse(struct stack_s symbols PARCELR_CONTEXT_PARAM) { //d
 //l bool parser_parse(struct stack_s symbols
 //rule.0.lhs.type
   //w , ${type} *value
 //e
-//w ) {
-  struct stack_s shifted = stack_make(16);
-
+//w  PARCELR_CONTEXT_PARAM) {
+#endif
   int state = 0;
 
+  /* lexemes left to shift before errors are reported again, and lexemes
+     skipped since the last error. The error lexeme comes before the rest
+     of the input while error_next is set, the input belongs to the caller
+     and is only ever popped */
+  unsigned recovering = 0;
+  unsigned discarded = 0;
+  bool error_next = false;
+
+#if defined(PARCELR_TAPE)
+  /* frames of a state and the length of the tape where its symbol starts,
+     the values are on the tape. start is where the subtree being reduced
+     starts once its children are popped, and child the node of the child
+     popped last */
+  struct parser_frame { parser_state state; unsigned start; };
+  typed_stack_s(struct parser_frame) shifted = {0};
+  unsigned start = 0;
+  unsigned child = 0;
+  tape->length = 0;
+  if (tape->data == NULL) tape->_context = PARCELR_CONTEXT_PTR;
+
+  #define MARK()\
+    start = tape->length
+  #define PUSH_STATE()\
+    typed_stack_push_in(PARCELR_CONTEXT_PTR, shifted, ((struct parser_frame){ (parser_state)state, start }))
+  #define POP()\
+    (child = start - 1, start = shifted.data[--shifted.length].start, (int)shifted.data[shifted.length].state)
+  #define PUSH_VALUE(type, stack, symbol, rule, value) do {\
+      struct parser_node _node = { symbol, rule, tape->length - start + 1, { ._##stack = value } };\
+      typed_stack_push_in(tape->_context, *tape, _node);\
+    } while (0)
+  #define POP_VALUE(type, stack)\
+    (tape->data[child].value._##stack)
+  #define RESULT(result)\
+    (void)(result)
+  #define UNWIND()\
+    tape->length = start
+  #define DESTROY()\
+    PARCELR_FREE(PARCELR_CONTEXT_PTR, shifted.data)
+#elif defined(PARCELR_TYPED_STACKS)
+  /* a dense stack of states and one stack per value type, symbols without
+     a type take no room at all */
+  typed_stack_s(parser_state) shifted = {0};
+  //type type index
+  //l typed_stack_s(${type}) values_${index} = {0};
+  //e
+
+  #define PUSH_STATE()\
+    typed_stack_push_in(PARCELR_CONTEXT_PTR, shifted, (parser_state)state)
+  #define POP()\
+    typed_stack_pop(shifted)
+  #define PUSH_VALUE(type, stack, symbol, rule, value)\
+    typed_stack_push_in(PARCELR_CONTEXT_PTR, values_##stack, value)
+  #define POP_VALUE(type, stack)\
+    typed_stack_pop(values_##stack)
+  #define MARK()
+  #define RESULT(result)\
+    *value = (result)
+  #define UNWIND()
+  #define DESTROY() //d
+  //l #define DESTROY()\
+  //l   PARCELR_FREE(PARCELR_CONTEXT_PTR, shifted.data)
+  //type type index
+    //w ; PARCELR_FREE(PARCELR_CONTEXT_PTR, values_${index}.data)
+  //e
+#else
+  /* frames of [value] [previous state] in words of a size_t */
+  struct stack_s shifted = stack_make_in(PARCELR_CONTEXT_PTR, 16);
+
+  #define PUSH_STATE()\
+    stack_push_in(PARCELR_CONTEXT_PTR, shifted, state)
+  #define POP()\
+    stack_pop(shifted, int)
+  #define PUSH_VALUE(type, stack, symbol, rule, value)\
+    stack_push_in(PARCELR_CONTEXT_PTR, shifted, value)
+  #define POP_VALUE(type, stack)\
+    stack_pop(shifted, type)
+  #define MARK()
+  #define RESULT(result)\
+    *value = (result)
+  #define UNWIND()
+  #define DESTROY()\
+    stack_destroy_in(PARCELR_CONTEXT_PTR, shifted)
+#endif
+
+#ifdef PARCELR_PROFILE
+  unsigned depth = 0;
+  parser_profile_data.parses++;
+
+  #define PROFILE_STATE()\
+    parser_profile_data.states[state]++
+  #define PROFILE_SHIFT()\
+    if (++depth > parser_profile_data.max_depth) parser_profile_data.max_depth = depth
+  #define PROFILE_REDUCE(rule, length)\
+    parser_profile_data.rules[rule]++;\
+    depth -= length
+#else
+  #define PROFILE_STATE()
+  #define PROFILE_SHIFT()
+  #define PROFILE_REDUCE(rule, length)
+#endif
+
   while (true) {
-    parser_symbol next = stack_peek(symbols, parser_symbol);
+    parser_symbol next = error_next ? SYMBOL_ERR : stack_peek(symbols, parser_symbol);
+    PROFILE_STATE();
+    MARK();
 
-    #define POP()\
-      stack_pop(shifted, int)
-    #define POP_CHILD(type, index)\
-      POP(); type _##index = stack_pop(shifted, type)
-    #define SHIFT_PUSH(newstate, type)\
+    #define POP_CHILD(type, index, stack)\
+      POP(); type _##index = POP_VALUE(type, stack)
+    #define SHIFT_PUSH(newstate, type, stack)\
       stack_pop(symbols, parser_symbol);\
-      _stack_push(&shifted, sizeof(type), _stack_pop(&symbols, sizeof(type)));\
-      stack_push(shifted, state);\
+      type _value = stack_pop(symbols, type);\
+      PUSH_VALUE(type, stack, next, 0, _value);\
+      PUSH_STATE();\
+      PROFILE_SHIFT();\
+      if (recovering) recovering--;\
       state = newstate
     #define SHIFT(newstate)\
-      stack_pop(symbols, parser_symbol);\
-      stack_push(shifted, state);\
+      if (next == SYMBOL_ERR && error_next) error_next = false;\
+      else stack_pop(symbols, parser_symbol);\
+      PUSH_STATE();\
+      PROFILE_SHIFT();\
+      if (recovering) recovering--;\
       state = newstate
-    #define REDUCE(symbol)\
-      parser_symbol sym = SYMBOL_##symbol;\
-      stack_push(symbols, sym)
+    #define GOTO(symbol)\
+      PUSH_STATE();\
+      PROFILE_SHIFT();\
+      state = parser_goto(state, SYMBOL_##symbol)
 
     switch (state) {
     //state
       //l case ${state.index}:
       //l {
         switch (next) {
-      //state.lookahead lah
+      //state.action lah
         //lah.accept
           //lah.symbol
           //l case SYMBOL_${symbol.enum}:
           //e
           //l {
           //rule.0.lhs.type
-            //l POP_CHILD(${type}, 0);
-            //l *value = _0;
+            //l POP_CHILD(${type}, 0, ${rule.0.lhs.type_index});
+            //l RESULT(_0);
           //e
-          //l   stack_destroy(shifted);
+          //l   DESTROY();
           //l   return true;
           //l }
         //e
@@ -70,7 +295,7 @@ bool parser_parse(struct stack_s symbols) { //d
           //e
             //w (${shift}
           //symbol.type
-            //w , ${type}
+            //w , ${type}, ${symbol.type_index}
           //e
             //w );
           //l   continue;
@@ -82,7 +307,7 @@ bool parser_parse(struct stack_s symbols) { //d
           //l case SYMBOL_${symbol.enum}:
           //e
           //l {
-          //reduce.lhs.type
+          //reduce.rhs.length
            //l
             //reduce.rhs.reversed child _ index
                 //f  state =
@@ -92,30 +317,72 @@ bool parser_parse(struct stack_s symbols) { //d
               //e
                 //w (
               //child.type
-                //w ${type}, ${index}
+                //w ${type}, ${index}, ${child.type_index}
               //e
                 //w );
             //e
+          //e
+          //reduce.lhs.type
             //l ${type} this;
             //reduce.code
               //w  ${code}
             //e
-            //l stack_push(symbols, this);
+            //l PUSH_VALUE(${type}, ${reduce.lhs.type_index}, SYMBOL_${reduce.lhs.enum}, ${reduce.index}, this);
           //e
-          //l   REDUCE(${reduce.lhs.enum});
+          //l   PROFILE_REDUCE(${reduce.index}, ${reduce.rhs.length});
+          //l   GOTO(${reduce.lhs.enum});
           //l   continue;
           //l }
         //e
       //e
           default:
-          {
-            stack_destroy(shifted);
-            return false;
-          }
+            goto error;
         }
       //l }
     //e
     }
+
+    /* only reached through goto, shared by every state and kept out of
+       the hot path */
+  error: PARCELR_COLD;
+    if (recovering >= 3) {
+      /* nothing shifted since the last error, skip the lexeme */
+      if (next == SYMBOL_EOF || discarded++ == PARCELR_MAX_DISCARD) break;
+      if (error_next) error_next = false;
+      else parser_discard(&symbols);
+      continue;
+    }
+    if (recovering == 0) {
+      PARCELR_REPORT_ERROR(state, next);
+    }
+
+    /* unwind to the nearest state with an action on error */
+    while (!(parser_error_mask[state / 32] >> (state % 32) & 1)) {
+      if (shifted.length == 0) goto fail;
+      int previous = POP();
+      switch (state) {
+      //state
+      //state.entry
+      //entry.type
+        //l case ${state.index}: (void)POP_VALUE(${type}, ${entry.type_index}); break;
+      //e
+      //e
+      //e
+        default: break;
+      }
+      state = previous;
+    }
+    UNWIND();
+
+    /* the error lexeme is shifted as well, three more have to be shifted
+       before the next error is reported */
+    error_next = true;
+    recovering = 4;
+    discarded = 0;
   }
+
+fail:
+  DESTROY();
+  return false;
 }
 
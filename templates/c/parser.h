@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "stack.h"
 
@@ -16,11 +17,136 @@ typedef enum { SYMBOL_EOF, SYMBOL_ERR } parser_symbol; //d
 //e
 //w  } parser_symbol;
 
+/* parsers keep all of their state in the call and only read the static
+   tables, so any number of them can run at the same time on different
+   threads, profiled ones are the exception as they share their counters.
+   Define PARCELR_CONTEXT as a type to pass each call a pointer to one as
+   the last argument, which rule code reads as context, e.g. to allocate
+   from storage owned by the caller instead of anything global. The
+   parsers themselves allocate through PARCELR_REALLOC and PARCELR_FREE of
+   stack.h, which are handed the context as well */
+#ifdef PARCELR_CONTEXT
+  #define PARCELR_CONTEXT_PARAM , PARCELR_CONTEXT *context
+  #define PARCELR_CONTEXT_ARG   , context
+  #define PARCELR_CONTEXT_PTR   context
+#else
+  #define PARCELR_CONTEXT_PARAM
+  #define PARCELR_CONTEXT_ARG
+  #define PARCELR_CONTEXT_PTR   NULL
+#endif
+
+/* the narrowest types holding every state and every symbol, used for the
+   tables and the typed state stack */
+typedef uint8_t parser_state;     //d
+typedef uint8_t parser_symbol_id; //d
+//l typedef uint${state_width}_t parser_state;
+//l typedef uint${symbol_width}_t parser_symbol_id;
+
+#ifdef PARCELR_TAPE
+/* parsers compiled with -DPARCELR_TAPE write a tape instead of returning
+   the value of the start symbol: a node for every lexeme and nonterminal
+   with a type, in postorder in one array. The value of a node is the value
+   of its symbol, set by the code of its rule for nonterminals.
+
+   Every node comes right after its subtree, the size nodes ending with
+   itself, so the last child of a node is the one before it and each child
+   comes right after the subtree of its previous sibling. Symbols without a
+   type get no node, their children are children of the nearest ancestor
+   with one. Nodes only refer to each other by position, so a tape can be
+   copied or written out as it is */
+typedef union {
+  unsigned char _none; /* for grammars without types */
+  //type type index
+  //l ${type} _${index};
+  //e
+} parser_payload;
+
+typedef uint8_t parser_rule_id; //d
+//l typedef uint${rule_width}_t parser_rule_id;
+
+struct parser_node {
+  parser_symbol_id symbol;
+  parser_rule_id   rule; /* reduced to the node, unused for lexemes */
+  uint32_t         size;
+  parser_payload   value;
+};
+
+struct parser_tape {
+  struct parser_node *data;
+  unsigned            length;
+  unsigned            _capacity;
+  void               *_context; /* of the parse that allocated data */
+};
+
+/* the sibling before a node, or a node outside the subtree of its parent
+   when it is the first child */
+#define parser_tape_previous(tape, node) ((node) - (tape).data[node].size)
+
+void parser_tape_destroy(struct parser_tape *tape);
+#endif
+
+/* grammars with error rules recover from syntax errors and still return
+   true, define PARCELR_REPORT_ERROR(state, symbol) when compiling
+   parser.c to be told about each of them. A tape is cleared before it is
+   written, so one can be parsed into again and again, and allocates with
+   the context of the parse that first wrote it until it is destroyed */
 const char *parser_symbol_name(parser_symbol symbol);
-      bool  parser_parse      (struct stack_s lexemes); //d
+#ifdef PARCELR_TAPE
+      bool  parser_parse      (struct stack_s lexemes, struct parser_tape *tape PARCELR_CONTEXT_PARAM);
+#else
+      bool  parser_parse      (struct stack_s lexemes PARCELR_CONTEXT_PARAM); //d
 //l       bool  parser_parse      (struct stack_s lexemes
 //rule.0.lhs.type
   //w , ${type} *value
 //e
-//w );
+//w  PARCELR_CONTEXT_PARAM);
+#endif
+
+//split
+#ifndef PARCELR_TAPE
+/* grammars with a %split are parsed by split.c in pieces on several
+   threads at once: the input is cut at separators of the top level list
+   into lists of their own, which are parsed like parser_parse would and
+   merged in order by the code of the %split. The lexemes are only read.
+   With PARCELR_CONTEXT the context points to one per thread, the pieces a
+   thread parses get its own and merging gets the first. When a piece does
+   not parse, the values of the others are dropped like a failed parse
+   drops its values, and recovered errors are local to their piece */
+      bool  parser_parse_split(struct stack_s lexemes, unsigned threads PARCELR_CONTEXT_PARAM); //d
+//l       bool  parser_parse_split(struct stack_s lexemes, unsigned threads
+//split.list.type
+  //w , ${type} *value
+//e
+//w  PARCELR_CONTEXT_PARAM);
+#endif
+//e
+
+#ifdef PARCELR_PROFILE
+#include <stdio.h>
+
+#define PARCELR_STATES 1 //d
+#define PARCELR_RULES  1 //d
+//l #define PARCELR_STATES ${state.length}
+//l #define PARCELR_RULES  ${rule.length}
+
+struct parser_rule {
+  parser_symbol_id        lhs;
+  unsigned                length;
+  const parser_symbol_id *rhs;
+};
+
+/* collected over every parse while compiled with -DPARCELR_PROFILE,
+   clear parser_profile_data to start over. Parses on several threads at
+   once lose counts */
+typedef struct {
+  unsigned long parses;
+  unsigned long states[PARCELR_STATES]; /* decisions taken in each state */
+  unsigned long rules[PARCELR_RULES];   /* reductions of each rule */
+  unsigned      max_depth;              /* most symbols on the stack at once */
+} parser_profile;
+
+extern       parser_profile     parser_profile_data;
+extern const struct parser_rule parser_rules[PARCELR_RULES];
 
+void parser_profile_write(FILE *file, const parser_profile *profile);
+#endif
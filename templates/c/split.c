@@ -0,0 +1,158 @@
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "parser.h"
+
+//split
+#ifdef PARCELR_TAPE
+  #error "split.c returns the value of the list, build it without PARCELR_TAPE"
+#endif
+
+/* pieces the input is cut into per thread, with more than one a thread
+   that finishes early takes over pieces another one has not started */
+#ifndef PARCELR_SPLIT_PIECES
+  #define PARCELR_SPLIT_PIECES 4
+#endif
+
+/* words the lexeme on top of the input takes up along with its value */
+static unsigned parser_split_words(parser_symbol symbol) {
+  switch (symbol) {
+  //symbol
+  //symbol.lexeme
+  //symbol.type
+    //l case SYMBOL_${symbol.enum}: return 1 + (sizeof(${type}) - 1) / sizeof(size_t) + 1;
+  //e
+  //e
+  //e
+    default: return 1;
+  }
+}
+
+/* the words of the input from start up to end, without the separators
+   around them */
+struct parser_piece {
+  unsigned start;
+  unsigned end;
+  bool     ok;
+  int      value; //d
+  //split.list.type
+  //l ${type} value;
+  //e
+};
+
+struct parser_split {
+  struct stack_s       lexemes;
+  struct parser_piece *pieces;
+  unsigned             length;
+  atomic_uint          next;
+};
+
+struct parser_worker {
+  struct parser_split *split;
+  pthread_t            thread;
+#ifdef PARCELR_CONTEXT
+  PARCELR_CONTEXT     *context;
+#endif
+};
+
+/* parses pieces in the order they come until none are left */
+static void *parser_split_work(void *arg) {
+  struct parser_worker *worker = (struct parser_worker*)arg;
+  struct parser_split *split = worker->split;
+#ifdef PARCELR_CONTEXT
+  PARCELR_CONTEXT *context = worker->context;
+  (void)context;
+#endif
+
+  for (unsigned i; (i = atomic_fetch_add(&split->next, 1)) < split->length;) {
+    struct parser_piece *piece = &split->pieces[i];
+
+    /* a stack of its own ending in EOF, as the parser pops it, allocated
+       with the context of the worker */
+    unsigned words = piece->end - piece->start;
+    struct stack_s lexemes = stack_make_in(PARCELR_CONTEXT_PTR, words + 1);
+    parser_symbol eof = SYMBOL_EOF;
+    stack_push_in(PARCELR_CONTEXT_PTR, lexemes, eof);
+    memcpy(&lexemes.data[1], &split->lexemes.data[piece->start], sizeof(size_t) * words);
+    lexemes.length += words;
+
+    piece->ok = parser_parse(lexemes, &piece->value PARCELR_CONTEXT_ARG); //d
+    //l piece->ok = parser_parse(lexemes
+    //split.list.type
+      //w , &piece->value
+    //e
+    //w  PARCELR_CONTEXT_ARG);
+    stack_destroy_in(PARCELR_CONTEXT_PTR, lexemes);
+  }
+  return NULL;
+}
+
+bool parser_parse_split(struct stack_s lexemes, unsigned threads PARCELR_CONTEXT_PARAM) { //d
+//l bool parser_parse_split(struct stack_s lexemes, unsigned threads
+//split.list.type
+  //w , ${type} *value
+//e
+//w  PARCELR_CONTEXT_PARAM) {
+  if (threads == 0) threads = 1;
+
+  /* the input only has to be walked for the separators, the first lexeme
+     is on top and EOF at the bottom. A piece ends at the first separator
+     past its share of the words */
+  struct parser_split split = { lexemes, NULL, 0, 0 };
+  unsigned most = threads * PARCELR_SPLIT_PIECES;
+  unsigned share = lexemes.length / most + 1;
+  split.pieces = (struct parser_piece*)PARCELR_REALLOC(PARCELR_CONTEXT_PTR, NULL, sizeof(struct parser_piece) * most);
+
+  unsigned end = lexemes.length;
+  for (unsigned top = lexemes.length; top > 1;) {
+    parser_symbol symbol = *(parser_symbol*)&lexemes.data[top - 1];
+    unsigned words = parser_split_words(symbol);
+    top -= words;
+
+    if (symbol == SYMBOL_EOF && end - (top + words) >= share && split.length + 1 < most) { //d
+    //l if (symbol == SYMBOL_${split.separator.enum} && end - (top + words) >= share && split.length + 1 < most) {
+      split.pieces[split.length++] = (struct parser_piece){ top + words, end };
+      end = top;
+    }
+  }
+  split.pieces[split.length++] = (struct parser_piece){ 1, end };
+
+  /* the calling thread is the first worker */
+  if (threads > split.length) threads = split.length;
+  struct parser_worker *workers = (struct parser_worker*)PARCELR_REALLOC(PARCELR_CONTEXT_PTR, NULL, sizeof(struct parser_worker) * threads);
+  for (unsigned i = 0; i < threads; i++) {
+    workers[i].split = &split;
+#ifdef PARCELR_CONTEXT
+    workers[i].context = context + i;
+#endif
+    if (i > 0) pthread_create(&workers[i].thread, NULL, parser_split_work, &workers[i]);
+  }
+  parser_split_work(&workers[0]);
+  for (unsigned i = 1; i < threads; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+  PARCELR_FREE(PARCELR_CONTEXT_PTR, workers);
+
+  bool ok = true;
+  for (unsigned i = 0; i < split.length; i++) {
+    ok = ok && split.pieces[i].ok;
+  }
+
+  //split.list.type
+  /* merged in input order, by the code of the %split */
+  //l if (ok) {
+    //l ${type} _0 = split.pieces[0].value;
+    //l for (unsigned i = 1; i < split.length; i++) {
+      //l ${type} _1 = split.pieces[i].value;
+      //l ${type} this;
+      //l ${split.code}
+      //l _0 = this;
+    //l }
+    //l *value = _0;
+  //l }
+  //e
+
+  PARCELR_FREE(PARCELR_CONTEXT_PTR, split.pieces);
+  return ok;
+}
+//e
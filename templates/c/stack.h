@@ -4,41 +4,58 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* everything the stacks and parsers allocate goes through these, define
+   both to allocate elsewhere. context is the PARCELR_CONTEXT of the parse
+   as a pointer to cast back, or NULL for parsers built without one and for
+   the memory of the caller, like stacks made with stack_make */
+#ifndef PARCELR_REALLOC
+  #define PARCELR_REALLOC(context, ptr, size) realloc(ptr, size)
+#endif
+#ifndef PARCELR_FREE
+  #define PARCELR_FREE(context, ptr) free(ptr)
+#endif
+
 struct stack_s {
   size_t  *data;
   unsigned length;
   unsigned _capacity;
 };
 
-#define stack_make(length) ((struct stack_s){(size_t*)malloc(sizeof(size_t) * length), 0, length})
+/* the _in variants allocate with the given context, a stack is always
+   grown and destroyed with the context it was made with */
+#define stack_make(length) stack_make_in(NULL, length)
+#define stack_make_in(context, length)\
+  ((struct stack_s){(size_t*)PARCELR_REALLOC(context, NULL, sizeof(size_t) * (length)), 0, (length)})
+
+#define stack_destroy(stack) stack_destroy_in(NULL, stack)
 
-static void stack_destroy(struct stack_s stack) {
-  free(stack.data);
+static void stack_destroy_in(void *context, struct stack_s stack) {
+  (void)context;
+  PARCELR_FREE(context, stack.data);
   stack.length = 0;
   stack._capacity = 0;
 }
 
-static void _stack_resize(struct stack_s *stack, unsigned length) {
-  size_t* newdata = (size_t*)malloc(sizeof(size_t) * length);
-  memcpy(newdata, stack->data, sizeof(size_t) * length);
-
-  free(stack->data);
-  stack->data = newdata;
+static void _stack_resize(void *context, struct stack_s *stack, unsigned length) {
+  (void)context;
+  stack->data = (size_t*)PARCELR_REALLOC(context, stack->data, sizeof(size_t) * length);
   stack->_capacity = length;
 }
 
-#define stack_push(stack, elem) _stack_push(&stack, sizeof(elem), &elem)
+#define stack_push(stack, elem) _stack_push(NULL, &stack, sizeof(elem), &elem)
+#define stack_push_in(context, stack, elem) _stack_push(context, &stack, sizeof(elem), &elem)
 
-static void _stack_push(struct stack_s *stack, size_t size, void *data) {
+static void _stack_push(void *context, struct stack_s *stack, size_t size, void *data) {
   unsigned length = (size - 1) / sizeof(size_t) + 1;
   unsigned newcap = stack->_capacity;
   while (stack->length + length > newcap) newcap *= 2;
 
   if (newcap > stack->_capacity) {
-    _stack_resize(stack, newcap);
+    _stack_resize(context, stack, newcap);
   }
 
-  memcpy(&stack->data[stack->length], data, length * sizeof(size_t));
+  /* only size bytes, elem may be smaller than the words it takes up */
+  memcpy(&stack->data[stack->length], data, size);
   stack->length += length;
 }
 
@@ -55,3 +72,24 @@ static void *_stack_peek(struct stack_s stack, size_t size) {
   unsigned length = (size - 1) / sizeof(size_t) + 1;
   return &stack.data[stack.length - length];
 }
+
+/* a stack of a single type, used for the value and state stacks when the
+   parser is built with PARCELR_TYPED_STACKS */
+#define typed_stack_s(type) struct { type *data; unsigned length; unsigned _capacity; }
+
+#define typed_stack_push(stack, elem) typed_stack_push_in(NULL, stack, elem)
+#define typed_stack_push_in(context, stack, elem) do {\
+    if ((stack).length == (stack)._capacity)\
+      (stack).data = _typed_stack_grow(context, (stack).data, &(stack)._capacity, sizeof(*(stack).data));\
+    (stack).data[(stack).length++] = (elem);\
+  } while (0)
+
+#define typed_stack_pop(stack) ((stack).data[--(stack).length])
+
+/* returns the grown data, which may have moved */
+static void *_typed_stack_grow(void *context, void *data, unsigned *capacity, size_t size) {
+  (void)context;
+  unsigned newcap = *capacity ? *capacity * 2 : 16;
+  *capacity = newcap;
+  return PARCELR_REALLOC(context, data, size * newcap);
+}
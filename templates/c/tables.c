@@ -0,0 +1,189 @@
+#include "tables.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* see codegen/tables.odin for the layout */
+#define TABLES_MAGIC   0x524c4350u
+#define TABLES_VERSION 2u
+#define TABLES_HEADER  10
+
+static void tables_clear(struct tables *t) {
+  memset(t, 0, sizeof(*t));
+}
+
+/* every index is inside the array it indexes and every cell names a state
+   or rule that exists, so parsing only reads inside the mapping */
+static bool tables_check(const struct tables *t, uint32_t action_rows, uint32_t goto_rows, uint32_t name_bytes) {
+  if (t->states == 0 || t->symbols == 0 || t->lexeme[0] != 1) return false;
+  if (name_bytes == 0 || t->names[name_bytes - 1] != 0) return false;
+
+  for (uint32_t i = 0; i < t->symbols; i++) {
+    if (t->lexeme[i] > 1) return false;
+    if (t->column[i] >= (t->lexeme[i] ? t->lexemes : t->nonterminals)) return false;
+    if (t->name_offset[i] >= name_bytes) return false;
+  }
+  for (uint32_t i = 0; i < t->states; i++) {
+    if (t->action_row[i] >= action_rows || t->goto_row[i] >= goto_rows) return false;
+  }
+  for (size_t i = 0; i < (size_t)action_rows * t->lexemes; i++) {
+    int64_t action = t->action[i];
+    if (action > t->states || -action > (int64_t)t->rules + 1) return false;
+  }
+  for (size_t i = 0; i < (size_t)goto_rows * t->nonterminals; i++) {
+    if (t->go[i] < 0 || (uint32_t)t->go[i] > t->states) return false;
+  }
+  for (uint32_t i = 0; i < t->rules; i++) {
+    if (t->rule_lhs[i] >= t->symbols || t->lexeme[t->rule_lhs[i]]) return false;
+  }
+  return true;
+}
+
+bool tables_open(const char *path, struct tables *t) {
+  tables_clear(t);
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < TABLES_HEADER * sizeof(uint32_t)) {
+    close(fd);
+    return false;
+  }
+
+  size_t size = (size_t)st.st_size;
+  void *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) return false;
+
+  const uint32_t *words = (const uint32_t*)base;
+  if (words[0] != TABLES_MAGIC || words[1] != TABLES_VERSION) {
+    munmap(base, size);
+    return false;
+  }
+
+  t->_base        = base;
+  t->_size        = size;
+  t->states       = words[2];
+  t->lexemes      = words[3];
+  t->nonterminals = words[4];
+  t->symbols      = words[5];
+  t->rules        = words[6];
+  uint32_t action_rows = words[7];
+  uint32_t goto_rows   = words[8];
+  uint32_t name_bytes  = words[9];
+
+  /* in words, counted in 64 bits so a corrupt header cannot wrap */
+  uint64_t expected = TABLES_HEADER
+    + (uint64_t)t->symbols * 3
+    + (uint64_t)t->states * 2
+    + (uint64_t)action_rows * t->lexemes
+    + (uint64_t)goto_rows * t->nonterminals
+    + (uint64_t)t->rules * 2
+    + name_bytes / 4;
+  if (expected * sizeof(uint32_t) != size || name_bytes % 4 != 0) {
+    tables_close(t);
+    return false;
+  }
+
+  const uint32_t *next = words + TABLES_HEADER;
+  t->column      = next; next += t->symbols;
+  t->lexeme      = next; next += t->symbols;
+  t->action_row  = next; next += t->states;
+  t->action      = (const int32_t*)next; next += (size_t)action_rows * t->lexemes;
+  t->goto_row    = next; next += t->states;
+  t->go          = (const int32_t*)next; next += (size_t)goto_rows * t->nonterminals;
+  t->rule_lhs    = next; next += t->rules;
+  t->rule_length = next; next += t->rules;
+  t->name_offset = next; next += t->symbols;
+  t->names       = (const char*)next;
+
+  if (!tables_check(t, action_rows, goto_rows, name_bytes)) {
+    tables_close(t);
+    return false;
+  }
+  return true;
+}
+
+void tables_close(struct tables *t) {
+  if (t->_base) munmap((void*)t->_base, t->_size);
+  tables_clear(t);
+}
+
+const char *tables_symbol_name(const struct tables *t, unsigned symbol) {
+  return t->names + t->name_offset[symbol];
+}
+
+/* NULL when out of memory, states is freed then */
+static uint32_t *tables_push(uint32_t *states, size_t *top, size_t *capacity, uint32_t state) {
+  if (++*top == *capacity) {
+    *capacity *= 2;
+    uint32_t *grown = (uint32_t*)realloc(states, *capacity * sizeof(uint32_t));
+    if (!grown) {
+      free(states);
+      return NULL;
+    }
+    states = grown;
+  }
+  states[*top] = state;
+  return states;
+}
+
+bool tables_parse(const struct tables *t, const unsigned *input, size_t length,
+                  const struct tables_callbacks *callbacks, size_t *error) {
+  size_t capacity = 64, top = 0;
+  uint32_t *states = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+  if (!states) {
+    if (error) *error = length;
+    return false;
+  }
+  states[0] = 0;
+
+  int32_t accept = -(int32_t)t->rules - 1;
+  size_t position = 0;
+
+  for (;;) {
+    unsigned symbol = position < length ? input[position] : 0;
+    uint32_t state = states[top];
+    int32_t action = symbol < t->symbols && t->lexeme[symbol]
+      ? t->action[(size_t)t->action_row[state] * t->lexemes + t->column[symbol]]
+      : 0;
+
+    if (action > 0) {
+      states = tables_push(states, &top, &capacity, (uint32_t)action - 1);
+      if (!states) break;
+      if (callbacks && callbacks->shift) callbacks->shift(callbacks->user, symbol, position);
+      position += 1;
+    } else if (action == accept) {
+      free(states);
+      return true;
+    } else if (action < 0) {
+      uint32_t rule = (uint32_t)(-action - 1);
+      uint32_t lhs = t->rule_lhs[rule];
+      /* tables of another grammar can pop past the bottom or go nowhere */
+      if (t->rule_length[rule] > top) goto fail;
+      int32_t go = t->go[(size_t)t->goto_row[states[top - t->rule_length[rule]]] * t->nonterminals + t->column[lhs]];
+      if (go == 0) goto fail;
+
+      top -= t->rule_length[rule];
+      if (callbacks && callbacks->reduce) callbacks->reduce(callbacks->user, rule);
+      states = tables_push(states, &top, &capacity, (uint32_t)go - 1);
+      if (!states) break;
+    } else {
+      goto fail;
+    }
+  }
+
+  /* out of memory */
+  if (error) *error = length;
+  return false;
+
+fail:
+  if (error) *error = position;
+  free(states);
+  return false;
+}
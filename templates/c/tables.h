@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* a parser over the tables written by parcelr --emit-tables, which needs no
+   code generated for the grammar. The file is mapped read-only, so every
+   process parsing with the same file shares one copy of the tables.
+   Symbols are numbered as in the parser_symbol enum of parser.h, EOF is 0,
+   and rules as in parser_rules. The tables are little endian, opening them
+   fails on other machines.
+
+   Opening checks every index and cell of the file against the sizes in
+   its header, so a corrupt or truncated file fails to open instead of
+   being read out of bounds. A file that passes but was not written for
+   its grammar still never reads outside the tables, its parses can fail
+   or never finish though */
+
+struct tables {
+  const void     *_base;
+  size_t          _size;
+  uint32_t        states, lexemes, nonterminals, symbols, rules;
+  const uint32_t *column;      /* of each symbol in the action or goto rows */
+  const uint32_t *lexeme;      /* per symbol, 1 for lexemes and 0 for nonterminals */
+  const uint32_t *action_row;  /* per state, into action */
+  const int32_t  *action;      /* 0, state + 1 to shift, -(rule + 1) to reduce, -(rules + 1) to accept */
+  const uint32_t *goto_row;    /* per state, into go */
+  const int32_t  *go;          /* 0 or state + 1 */
+  const uint32_t *rule_lhs;
+  const uint32_t *rule_length;
+  const uint32_t *name_offset; /* per symbol, into names */
+  const char     *names;
+};
+
+/* false when the file cannot be mapped or is not a table file of this
+   version, t is left empty then */
+bool tables_open(const char *path, struct tables *t);
+void tables_close(struct tables *t);
+
+const char *tables_symbol_name(const struct tables *t, unsigned symbol);
+
+/* told about each step of a parse, either may be NULL: shift gets the
+   position of the lexeme in the input and reduce the rule, whose length
+   symbols are replaced by its lhs */
+struct tables_callbacks {
+  void (*shift)(void *user, unsigned symbol, size_t position);
+  void (*reduce)(void *user, unsigned rule);
+  void *user;
+};
+
+/* parses the lexemes of input up to the first EOF, returns false on a
+   syntax error and sets *error, when not NULL, to the position of the
+   lexeme that could not be parsed. Nonterminals in the input are syntax
+   errors. Also returns false when out of memory, with *error set to the
+   length of the input */
+bool tables_parse(const struct tables *t, const unsigned *input, size_t length,
+                  const struct tables_callbacks *callbacks, size_t *error);
@@ -9,8 +9,8 @@ import "core:strings"
 //l ${preamble}
 
 //e
-Symbol :: enum { EOF, ERR } //d
-//l Symbol :: enum {
+Symbol :: enum u8 { EOF, ERR } //d
+//l Symbol :: enum u${symbol_width} {
 //symbol
   //w  ${symbol.enum},
 //e
@@ -27,15 +27,131 @@ SymbolValue :: struct #raw_union {} //d
 
 SymbolPair :: struct { symbol: Symbol, value: SymbolValue }
 
-HANDLES_ERRORS := map[int]struct{}{} //d
-//l HANDLES_ERRORS := map[int]struct{}{
-//state
-  //state.lookahead.symbol.enum."ERR"
-    //w  ${state.index} = {},
+/* values larger than this are kept out of line in a pool per type and
+   the parse stack only holds their index, so its frames stay small */
+PARCELR_POOL_THRESHOLD :: #config(PARCELR_POOL_THRESHOLD, 16)
+
+/* keeps every value on a stack of its type instead, so the parse stack
+   holds nothing but states and symbols */
+PARCELR_TYPED_STACKS :: #config(PARCELR_TYPED_STACKS, false)
+
+/* the pool or typed stack of each type. Symbols of one type share it,
+   which --skip-units relies on: a bypassed unit rule leaves the value of
+   its child where the states after the parent look for it */
+Pools :: struct {} //d
+//l Pools :: struct {
+//type type index
+  //w  values_${index}: [dynamic]${type},
+//e
+//w  }
+
+delete_pools :: proc(pools: ^Pools) {
+//type type index
+  //l delete(pools.values_${index})
+//e
+}
+
+when PARCELR_TYPED_STACKS {
+  Slot :: struct {}
+} else {
+  //type type index
+  //l when size_of(${type}) > PARCELR_POOL_THRESHOLD {
+  //l   Slot_${index} :: u32
+  //l } else {
+  //l   Slot_${index} :: ${type}
+  //l }
+  //e
+
+  /* a value on the parse stack, either inline or an index into its pool */
+  Slot :: struct #raw_union {} //d
+  //l Slot :: struct #raw_union {
+  //type type index
+    //w  _${index}: Slot_${index},
+  //e
+  //w  }
+
+  store :: #force_inline proc(pool: ^[dynamic]$T, value: T, $S: typeid) -> S {
+    when S == T {
+      return value
+    } else {
+      append(pool, value)
+      return S(len(pool) - 1)
+    }
+  }
+
+  /* children are taken from last to first, values above them in the pool
+     belong to frames that are gone, so the pool is cut back */
+  take :: #force_inline proc(pool: ^[dynamic]$T, slot: $S) -> T {
+    when S == T {
+      return slot
+    } else {
+      value := pool[slot]
+      resize(pool, int(slot))
+      return value
+    }
+  }
+}
+
+/* moves a value in and out of the parse stack, in either layout */
+//symbol
+//symbol.type
+//l store_${symbol.enum} :: #force_inline proc(pools: ^Pools, value: ${type}) -> (slot: Slot) {
+//l   when PARCELR_TYPED_STACKS {
+//l     append(&pools.values_${symbol.type_index}, value)
+//l   } else {
+//l     slot._${symbol.type_index} = store(&pools.values_${symbol.type_index}, value, Slot_${symbol.type_index})
+//l   }
+//l   return
+//l }
+//l take_${symbol.enum} :: #force_inline proc(pools: ^Pools, slot: Slot) -> ${type} {
+//l   when PARCELR_TYPED_STACKS {
+//l     return pop(&pools.values_${symbol.type_index})
+//l   } else {
+//l     return take(&pools.values_${symbol.type_index}, slot._${symbol.type_index})
+//l   }
+//l }
+//e
+//e
+
+/* drops the value of a frame that recovery pops off the stack */
+discard :: proc(pools: ^Pools, frame: State) {
+  #partial switch frame.symbol {
+  //symbol
+  //symbol.type
+    //l case .${symbol.enum}: take_${symbol.enum}(pools, frame.value)
+  //e
+  //e
+  }
+}
+
+to_slot :: proc(pools: ^Pools, pair: SymbolPair) -> (slot: Slot) {
+  #partial switch pair.symbol {
+  //symbol
+  //symbol.lexeme
+  //symbol.type
+    //l case .${symbol.enum}: slot = store_${symbol.enum}(pools, pair.value.${symbol.enum})
   //e
+  //e
+  //e
+  }
+  return
+}
+
+/* states with an action on error, bit i of word i / 32 */
+ERROR_MASK := [?]u32{} //d
+//l ERROR_MASK := [?]u32{
+//error_mask
+  //w  ${error_mask},
 //e
 //w  }
 
+handles_error :: #force_inline proc(state: int) -> bool {
+  return ERROR_MASK[state / 32] >> uint(state % 32) & 1 != 0
+}
+
+/* lexemes skipped to resynchronise after an error before giving up */
+PARCELR_MAX_DISCARD :: #config(PARCELR_MAX_DISCARD, 256)
+
 symbol_name :: proc(symbol: Symbol) -> string {
   switch symbol {
     case .EOF: return "EOF" //d
@@ -47,7 +163,64 @@ symbol_name :: proc(symbol: Symbol) -> string {
   return ""
 }
 
-PARCELR_DEBUG :: true
+PARCELR_DEBUG :: #config(PARCELR_DEBUG, true)
+PARCELR_PROFILE :: #config(PARCELR_PROFILE, false)
+
+when PARCELR_PROFILE {
+  STATE_COUNT :: 1 //d
+  RULE_COUNT :: 1 //d
+  //l STATE_COUNT :: ${state.length}
+  //l RULE_COUNT :: ${rule.length}
+
+  Rule :: struct { lhs: Symbol, rhs: []Symbol }
+
+  RULES := [RULE_COUNT]Rule {
+  //rule
+    //l { .${rule.lhs.enum}, {
+    //rule.rhs
+      //w  .${rhs.enum}
+      //s ,
+    //e
+    //w  } },
+  //e
+  }
+
+  /* collected over every parse, reset profile to start over */
+  Profile :: struct {
+    parses:    int,
+    states:    [STATE_COUNT]int, /* decisions taken in each state */
+    rules:     [RULE_COUNT]int,  /* reductions of each rule */
+    max_depth: int,              /* most symbols on the stack at once */
+  }
+
+  profile: Profile
+
+  /* states are written with the index the analyser gave them, which stays
+     the same when parcelr --profile renumbers them */
+  STATE_IDS := [STATE_COUNT]StateIndex{} //d
+  //l STATE_IDS := [STATE_COUNT]StateIndex{
+  //state
+    //w  ${state.id},
+  //e
+  //w  }
+
+  /* one line per counter, rules are followed by their text:
+     parses N, depth N, state ID N, rule INDEX N LHS -> RHS... */
+  profile_write :: proc(fd: os.Handle, p: Profile) {
+    fmt.fprintf(fd, "parses %d\n", p.parses)
+    fmt.fprintf(fd, "depth %d\n", p.max_depth)
+    for count, i in p.states {
+      fmt.fprintf(fd, "state %d %d\n", STATE_IDS[i], count)
+    }
+    for count, i in p.rules {
+      fmt.fprintf(fd, "rule %d %d %s ->", i, count, symbol_name(RULES[i].lhs))
+      for symbol in RULES[i].rhs {
+        fmt.fprintf(fd, " %s", symbol_name(symbol))
+      }
+      fmt.fprintln(fd)
+    }
+  }
+}
 
 when PARCELR_DEBUG {
   main :: proc() {
@@ -61,8 +234,10 @@ when PARCELR_DEBUG {
 
         for w in strs {
           switch w {
-          //symbol.lexeme
-            //l case "${lexeme.name}": append(&symbols, SymbolPair{ .${lexeme.enum}, --- })
+          //symbol
+            //symbol.lexeme
+              //l case "${symbol.name}": append(&symbols, SymbolPair{ .${symbol.enum}, --- })
+            //e
           //e
             case: append(&symbols, SymbolPair{ .ERR, --- })
           }
@@ -81,6 +256,79 @@ when PARCELR_DEBUG {
   }
 }
 
+/* the narrowest type holding every state */
+StateIndex :: u8 //d
+//l StateIndex :: u${state_width}
+
+State :: struct { symbol: Symbol, value: Slot, state: StateIndex }
+
+/* the state entered after reducing to a nonterminal */
+goto_state :: proc(state: int, symbol: Symbol) -> int {
+  switch state {
+  //state
+  //state.goto.length
+    //l case ${state.index}:
+      //l #partial switch symbol {
+  //state.goto g
+  //g.shift
+        //l case
+  //g.symbol
+          //w  .${symbol.enum}
+          //s ,
+  //e
+          //w : return ${shift}
+  //e
+  //e
+      //l }
+  //e
+  //e
+  }
+  return -1
+}
+
+/* the progress of recovering from the last error */
+Recovery :: struct {
+  shifts:    int, /* lexemes left to shift before errors are reported again */
+  discarded: int, /* lexemes skipped since the last error */
+}
+
+/* runs when no case matched, only on bad input, so it is kept out of line.
+   Like yacc, it unwinds to the nearest state with an action on error and
+   shifts an error lexeme there, lexemes that still do not fit are skipped.
+   Every frame and lexeme is dropped at most once, so it is linear in the
+   input. */
+@(cold)
+recover :: proc(stack: ^[dynamic]SymbolPair, shifted: ^#soa[dynamic]State, pools: ^Pools, state: ^int, recovery: ^Recovery, symbol: Symbol) -> bool {
+  if recovery.shifts >= 3 {
+    /* nothing shifted since the last error, skip the lexeme */
+    if len(stack) == 0 || recovery.discarded == PARCELR_MAX_DISCARD do return false
+    recovery.discarded += 1
+    pop(stack)
+    return true
+  }
+
+  when PARCELR_DEBUG {
+    if recovery.shifts == 0 do fmt.printf("    error in %i at %s\n", state^, symbol_name(symbol))
+  }
+
+  /* walk the state column down to the nearest frame that handles error,
+     then cut the stack back once */
+  top := len(shifted)
+  for !handles_error(state^) {
+    if top == 0 do return false
+    top -= 1
+    discard(pools, shifted[top])
+    state^ = int(shifted[top].state)
+  }
+  resize_soa(shifted, top)
+
+  /* the error lexeme is shifted as well, three more have to be shifted
+     before the next error is reported */
+  append(stack, SymbolPair{ .ERR, --- })
+  recovery^ = { 4, 0 }
+  return true
+}
+
 parse :: proc(lexemes: []SymbolPair) -> bool { // d
 //l parse :: proc(lexemes: []SymbolPair) -> (
 //rule.0.lhs.type
@@ -97,14 +345,14 @@ parse :: proc(lexemes: []SymbolPair) -> bool { // d
     stack[a] = tmp
   }
 
-  State :: struct { symbol: Symbol, value: SymbolValue, state: int }
-
   shifted: #soa[dynamic]State
+  pools: Pools
   state := 0
-  errors := 0
+  recovery: Recovery
 
   defer delete(stack)
   defer delete_soa(shifted)
+  defer delete_pools(&pools)
 
   peek :: proc(a: []SymbolPair) -> Symbol {
     i := len(a) - 1
@@ -112,22 +360,24 @@ parse :: proc(lexemes: []SymbolPair) -> bool { // d
     return .EOF
   }
 
-  shift :: proc(stack: ^[dynamic]SymbolPair, shifted: ^#soa[dynamic]State, state: ^int, new_state: int, errors: ^int) {
+  shift :: proc(stack: ^[dynamic]SymbolPair, shifted: ^#soa[dynamic]State, pools: ^Pools, state: ^int, new_state: int, recovery: ^Recovery) {
     val := pop_safe(stack) or_else SymbolPair{ .EOF, --- }
-    if val.symbol == .ERR do errors^ += 1
-    append_soa(shifted, State { val.symbol, val.value, state^ })
+    if recovery.shifts > 0 do recovery.shifts -= 1
+    append_soa(shifted, State { val.symbol, to_slot(pools, val), StateIndex(state^) })
     state^ = new_state
+    when PARCELR_PROFILE do profile.max_depth = max(profile.max_depth, len(shifted))
   }
 
-  reduce :: proc(stack: ^[dynamic]SymbolPair, shifted: ^#soa[dynamic]State, state: ^int, errors: ^int, f: $T/proc(children: [$N]SymbolValue) -> SymbolPair) {
-    vals: [N]SymbolValue = ---
-    when N > 0 {
-      _, values, _ := soa_unzip(shifted^[:])
-      copy_slice(vals[:], values[len(values) - N:])
-      state^ = shifted[len(shifted) - N].state
-      resize_soa(shifted, len(shifted) - N)
+  /* the children of a reduction are read where they are on the stack,
+     this drops their frames and pushes the nonterminal in their place */
+  reduce :: #force_inline proc(shifted: ^#soa[dynamic]State, state: ^int, base: int, symbol: Symbol, value: Slot) {
+    if base < len(shifted) {
+      state^ = int(shifted[base].state)
+      resize_soa(shifted, base)
     }
-    append(stack, f(vals))
+    append_soa(shifted, State { symbol, value, StateIndex(state^) })
+    state^ = goto_state(state^, symbol)
+    when PARCELR_PROFILE do profile.max_depth = max(profile.max_depth, len(shifted))
   }
 
   when PARCELR_DEBUG {
@@ -148,14 +398,17 @@ parse :: proc(lexemes: []SymbolPair) -> bool { // d
     }
   }
 
+  when PARCELR_PROFILE do profile.parses += 1
+
   for {
     symbol := peek(stack[:])
+    when PARCELR_PROFILE do profile.states[state] += 1
     switch state {
     //state
       //l case ${state.index}:
       case 0: //d
         #partial switch symbol {
-        //state.lookahead lah
+        //state.action lah
           //l case
           //lah.symbol
             //w  .${symbol.enum}
@@ -169,12 +422,12 @@ parse :: proc(lexemes: []SymbolPair) -> bool { // d
             //l }
             //l return
             //rule.0.lhs.type
-              //w  shifted[0].value.${rule.0.lhs.enum},
+              //w  take_${rule.0.lhs.enum}(&pools, shifted[0].value),
             //e
             //w  true
           //e
           //lah.shift
-            //l shift(&stack, &shifted, &state, ${shift}, &errors)
+            //l shift(&stack, &shifted, &pools, &state, ${shift}, &recovery)
             //l continue
           //e
           //lah.reduce
@@ -182,23 +435,24 @@ parse :: proc(lexemes: []SymbolPair) -> bool { // d
             //l   dump(stack, shifted, state, ${reduce.rhs.length})
             //l   fmt.println("    reduce ${reduce}")
             //l }
-            //l reduce(&stack, &shifted, &state, &errors,
-            //l   proc (children: [${reduce.rhs.length}]SymbolValue) -> SymbolPair {
-            //l     ret: SymbolValue
+            //l when PARCELR_PROFILE do profile.rules[${reduce.index}] += 1
+            //l base := len(shifted) - ${reduce.rhs.length}
+            //l slot: Slot
+            //reduce.rhs.reversed child _ index
+            //child.type
+            //l _${index} := take_${child.enum}(&pools, shifted[base + ${index}].value)
+            //e
+            //e
             //reduce.lhs.type
-              //w ; this: ${type}
-              //reduce.rhs child index
-                //child.type
-                  //w ; _${index} := children[${index}].${child.enum}
-                //e
-              //e
-              //reduce.code
-                //l ${code}
-              //e
-              //l   ret.${reduce.lhs.enum} = this
+            //l this: ${type}
+            //reduce.code
+            //l {
+            //l   ${code}
+            //l }
+            //e
+            //l slot = store_${reduce.lhs.enum}(&pools, this)
             //e
-            //w ; return { .${reduce.lhs.enum}, ret }
-            //l   })
+            //l reduce(&shifted, &state, base, .${reduce.lhs.enum}, slot)
             //l continue
           //e
         //e
@@ -206,35 +460,11 @@ parse :: proc(lexemes: []SymbolPair) -> bool { // d
     //e
     }
 
-    if errors > 0 {
-      if state in HANDLES_ERRORS {
-        append(&stack, SymbolPair{ .ERR, --- })
-        continue
-      }
-
-      if len(stack) == 0 do return false //d
-      //l if len(stack) == 0 do return
-      //rule.0.lhs.type
-        //w  ---,
-      //e
-      //w  false
-      pop(&stack)
-      continue
-    }
-
-    if symbol != .ERR {
-      append(&stack, SymbolPair{ .ERR, --- })
-      continue
-    }
-
-    if len(shifted) == 0 do return false //d
-    //l if len(shifted) == 0 do return
+    if !recover(&stack, &shifted, &pools, &state, &recovery, symbol) do return false //d
+    //l if !recover(&stack, &shifted, &pools, &state, &recovery, symbol) do return
     //rule.0.lhs.type
       //w  ---,
     //e
     //w  false
-    state = shifted[len(shifted) - 1].state
-    resize_soa(&shifted, len(shifted) - 1)
-    continue
   }
 }